@@ -37,6 +37,8 @@ enum {
     DI_READ_DUTY_SUM_TIME = 4, // resd pulse on time
     DI_READ_PULSE_LEVEL		= 5,  // read input levels
     DI_READ_PIN_LEVEL = 6,      // read pin level
+    DI_SET_SAMPLE_STREAM = 7,   // select the pins which stream their edges
+    DI_READ_STATS = 8,          // read the performance statistics (InterCoreStats)
     DI_READ_VERSION = 255,      // read the RTApp version
 };
 
@@ -72,6 +74,18 @@ typedef struct DI_MsgPinId {
     // sizeof(DI_MsgPinId) == messageLen
 }DI_MsgPinId;
 
+// sample stream
+typedef struct DI_MsgSampleStream {
+    uint32_t	pinMask;  // bit n: stream the edges of pin n
+    // sizeof(DI_MsgSampleStream) == messageLen
+}DI_MsgSampleStream;
+
+// statistics
+typedef struct DI_MsgStats {
+    uint32_t	reset;  // reset the statistics after read (0: keep)
+    // sizeof(DI_MsgStats) == messageLen
+}DI_MsgStats;
+
 // message
 typedef struct DI_DriverMsg {
     DI_DriverMsgHdr	header;
@@ -79,6 +93,8 @@ typedef struct DI_DriverMsg {
         DI_MsgSetConfig    setConfig;
         DI_MsgResetPulseCount       resetPulseCount;
         DI_MsgPinId pinId;
+        DI_MsgSampleStream sampleStream;
+        DI_MsgStats stats;
     } body;
 } DI_DriverMsg;
 
@@ -30,9 +30,11 @@
 #include "DI_WatchItem.h"
 #include "LibCloud.h"
 #include "LibDI.h"
-#include "StringBuf.h"
 #include "TelemetryItems.h"
 
+// polling interval of contact inputs
+#define DI_WATCH_INTERVAL_MS	1000
+
 typedef struct DI_DataFetchScheduler {
     DataFetchSchedulerBase	Super;
 
@@ -46,7 +48,8 @@ typedef struct DI_DataFetchScheduler {
 //
 // Callback procedure of FetchTimers
 static void
-DI_FetchTimerCallback(void* arg, const FetchItemBase* fetchTarget)
+DI_FetchTimerCallback(void* arg, const FetchItemBase* fetchTarget,
+    uint64_t expiryMs)
 {
     // This procedure called against the acquisition target which  
     // timer expired
@@ -97,19 +100,17 @@ DI_DataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                 if (! DI_Lib_ReadPulseCount(item->pinID, &pulseCount)) {
                     continue;
                 };
-                StringBuf_AppendByPrintf(me->mStringBuf, "%lu", pulseCount);
+                TelemetryItems_AddUInt32(me->mTelemetryItems,
+                    item->telemetryKey, (uint32_t)pulseCount);
             } else {
                 unsigned int currentStatus = 0;
 
                 if (! DI_Lib_ReadPinLevel(item->pinID, &currentStatus)) {
                     continue;
                 };
-                StringBuf_AppendByPrintf(me->mStringBuf, "%ld", currentStatus);
+                TelemetryItems_AddUInt32(me->mTelemetryItems,
+                    item->telemetryKey, (uint32_t)currentStatus);
             }
-
-            TelemetryItems_Add(me->mTelemetryItems,
-                item->telemetryName, StringBuf_GetStr(me->mStringBuf));
-            StringBuf_Clear(me->mStringBuf);
         }
     }
 
@@ -122,14 +123,19 @@ DI_DataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
 
             vector_get_at(&wiStat, lastChanges, i);
 
-            StringBuf_AppendByPrintf(me->mStringBuf, "%ld", 1);
-            TelemetryItems_Add(me->mTelemetryItems,
-                wiStat->watchItem->telemetryName, StringBuf_GetStr(me->mStringBuf));
-            StringBuf_Clear(me->mStringBuf);
+            TelemetryItems_AddUInt32(me->mTelemetryItems,
+                wiStat->watchItem->telemetryKey, 1);
         }
     }
 }
 
+static bool
+DI_DataFetchScheduler_ReadRTAppStats(
+    DataFetchSchedulerBase* me, InterCoreStats* outStats)
+{
+    return DI_Lib_ReadStats(outStats, true);
+}
+
 DataFetchScheduler*
 DI_DataFetchScheduler_New(void)
 {
@@ -160,6 +166,7 @@ DI_DataFetchScheduler_New(void)
 //	super->DoInit    = DI_DataFetchScheduler_DoInit;  // don't override
     super->ClearFetchTargets = DI_DataFetchScheduler_ClearFetchTargets;
     super->DoSchedule        = DI_DataFetchScheduler_DoSchedule;
+    super->ReadRTAppStats    = DI_DataFetchScheduler_ReadRTAppStats;
 
     return super;
 err_delete_fetchTargets:
@@ -181,4 +188,7 @@ DI_DataFetchScheduler_Init(DataFetchScheduler* me,
 
     DataFetchScheduler_Init(me, fetchItemPtrs);
     DI_Watcher_Init(self->mWatcher, watchItems);
+    if (! vector_is_empty(watchItems)) {
+        FetchTimers_AddPollTimer(me->mFetchTimers, DI_WATCH_INTERVAL_MS);
+    }
 }
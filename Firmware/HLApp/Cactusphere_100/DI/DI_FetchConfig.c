@@ -46,6 +46,11 @@ const char CntIntervalDIKey[] = "cntInterval_DI";
 const char CntMinPulseWidthDIKey[] = "cntMinPulseWidth_DI";
 const char CntMaxPulseCountDIKey[] = "cntMaxPulseCount_DI";
 const char PollIntervalDIKey[] = "pollInterval_DI";
+const char DeadbandDIKey[] = "deadband_DI";
+const char DeadbandPercentDIKey[] = "deadbandPercent_DI";
+const char MaxSilenceDIKey[] = "maxSilence_DI";
+const char AggregateWindowDIKey[] = "aggregateWindow_DI";
+const char AggregateStddevDIKey[] = "aggregateStddev_DI";
 
 #define DI_FETCH_PORT_OFFSET 1
 
@@ -88,11 +93,12 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
     const json_value* json, bool desire, vector propertyItem, const char* version)
 {
     DI_FetchItem config[NUM_DI] = {
-        // telemetryName, intervalSec, pinID, isPulseCounter, isPulseHigh, isCountClear, minPulseWidth, maxPulseCount
-        {"", 1, 0, false, false, false, 200, 0x7FFFFFFF},
-        {"", 1, 1, false, false, false, 200, 0x7FFFFFFF},
-        {"", 1, 2, false, false, false, 200, 0x7FFFFFFF},
-        {"", 1, 3, false, false, false, 200, 0x7FFFFFFF}
+        // telemetryName, intervalMs, phaseMs, catchUp, pinID, isPulseCounter, isPulseHigh, isCountClear, minPulseWidth, maxPulseCount
+        // (the pins are read locally, so acquire them at once into one message)
+        {"", 1000, 0, FETCH_CATCHUP_SKIP, 0, false, false, false, 200, 0x7FFFFFFF},
+        {"", 1000, 0, FETCH_CATCHUP_SKIP, 1, false, false, false, 200, 0x7FFFFFFF},
+        {"", 1000, 0, FETCH_CATCHUP_SKIP, 2, false, false, false, 200, 0x7FFFFFFF},
+        {"", 1000, 0, FETCH_CATCHUP_SKIP, 3, false, false, false, 200, 0x7FFFFFFF}
     };
     bool overWrite[NUM_DI] = {false};
     bool ret = true;
@@ -102,6 +108,11 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
     const size_t cntMinPulseWidthDiLen = strlen(CntMinPulseWidthDIKey);
     const size_t cntMaxPulseCountDiLen = strlen(CntMaxPulseCountDIKey);
     const size_t pollIntervalDiLen = strlen(PollIntervalDIKey);
+    const size_t deadbandDiLen = strlen(DeadbandDIKey);
+    const size_t deadbandPercentDiLen = strlen(DeadbandPercentDIKey);
+    const size_t maxSilenceDiLen = strlen(MaxSilenceDIKey);
+    const size_t aggregateWindowDiLen = strlen(AggregateWindowDIKey);
+    const size_t aggregateStddevDiLen = strlen(AggregateStddevDIKey);
 
     char diCounterStr[PROPERTY_NAME_MAX_LEN];
     char diPollingStr[PROPERTY_NAME_MAX_LEN];
@@ -120,11 +131,6 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
     }
 
     if (0 != vector_size(me->mFetchItems)) {
-        DI_FetchItem*	curs = (DI_FetchItem*)vector_get_data(me->mFetchItems);
-
-        for (int i = 0, n = vector_size(me->mFetchItems); i < n; ++i) {
-            TelemetryItems_RemoveDictionaryElem(curs->telemetryName);
-        }
         vector_clear(me->mFetchItemPtrs);
         vector_clear(me->mFetchItems);
     }
@@ -162,7 +168,7 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
             if (!config[i].isPulseCounter || desire) {
                 // feature has changed
                 config[i].isCountClear = true;
-                config[i].intervalSec = 1;
+                config[i].intervalMs = 1000;
                 config[i].minPulseWidth = 200; // default
                 config[i].maxPulseCount = 0x7FFFFFFF; // default
             }
@@ -173,7 +179,7 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
             if (config[i].isPulseCounter || desire) {
                 // feacture has changed
                 config[i].isCountClear = true;
-                config[i].intervalSec = 1;
+                config[i].intervalMs = 1000;
                 config[i].minPulseWidth = 200; // default
                 config[i].maxPulseCount = 0x7FFFFFFF; // default
             }
@@ -222,10 +228,10 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
             int8_t result = json_GetIntValue(item, &value, 10);
             if (config[pinid].isPulseCounter) {
                 if (result && value >= 1 && value <= 86400) {
-                    if (config[pinid].intervalSec != value) {
+                    if (config[pinid].intervalMs != value * 1000) {
                         config[pinid].isCountClear = true;
                     }
-                    config[pinid].intervalSec = value;
+                    config[pinid].intervalMs = value * 1000;
                 } else {
                     ret = false;
                     overWrite[pinid] = false;
@@ -282,16 +288,84 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
 
             if (!config[pinid].isPulseCounter) {
                 if (result && value >= 1 && value <= 86400) {
-                    if (config[pinid].intervalSec != value) {
+                    if (config[pinid].intervalMs != value * 1000) {
                         config[pinid].isCountClear = true;
                     }
-                    config[pinid].intervalSec = value;
+                    config[pinid].intervalMs = value * 1000;
                 } else {
                     ret = false;
                     overWrite[pinid] = false;
                 }
             }
             PropertyItems_AddItem(propertyItem, propertyName, TYPE_NUM, value);
+        } else if (0 == strncmp(propertyName, DeadbandDIKey, deadbandDiLen)) {
+            pinid = strtol(&propertyName[deadbandDiLen], NULL, 10) - DI_FETCH_PORT_OFFSET;
+            if (pinid < 0 || pinid >= NUM_DI) {
+                continue;
+            }
+            uint32_t value = 0;
+
+            if (json_GetIntValue(item, &value, 10)) {
+                // 0 means reporting only when the value has changed
+                config[pinid].reportCond.deadbandType = DEADBAND_ABSOLUTE;
+                config[pinid].reportCond.deadband = (float)value;
+            } else {
+                ret = false;
+            }
+            PropertyItems_AddItem(propertyItem, propertyName, TYPE_NUM, value);
+        } else if (0 == strncmp(propertyName, DeadbandPercentDIKey, deadbandPercentDiLen)) {
+            pinid = strtol(&propertyName[deadbandPercentDiLen], NULL, 10) - DI_FETCH_PORT_OFFSET;
+            if (pinid < 0 || pinid >= NUM_DI) {
+                continue;
+            }
+            uint32_t value = 0;
+
+            if (json_GetIntValue(item, &value, 10)) {
+                config[pinid].reportCond.deadbandType = DEADBAND_PERCENT;
+                config[pinid].reportCond.deadband = (float)value;
+            } else {
+                ret = false;
+            }
+            PropertyItems_AddItem(propertyItem, propertyName, TYPE_NUM, value);
+        } else if (0 == strncmp(propertyName, MaxSilenceDIKey, maxSilenceDiLen)) {
+            pinid = strtol(&propertyName[maxSilenceDiLen], NULL, 10) - DI_FETCH_PORT_OFFSET;
+            if (pinid < 0 || pinid >= NUM_DI) {
+                continue;
+            }
+            uint32_t value = 0;
+
+            if (json_GetIntValue(item, &value, 10) && value <= 86400) {
+                config[pinid].reportCond.maxSilenceSec = value;
+            } else {
+                ret = false;
+            }
+            PropertyItems_AddItem(propertyItem, propertyName, TYPE_NUM, value);
+        } else if (0 == strncmp(propertyName, AggregateWindowDIKey, aggregateWindowDiLen)) {
+            pinid = strtol(&propertyName[aggregateWindowDiLen], NULL, 10) - DI_FETCH_PORT_OFFSET;
+            if (pinid < 0 || pinid >= NUM_DI) {
+                continue;
+            }
+            uint32_t value = 0;
+
+            if (json_GetIntValue(item, &value, 10) && value <= 86400) {
+                config[pinid].reportCond.aggregateWindowSec = value;
+            } else {
+                ret = false;
+            }
+            PropertyItems_AddItem(propertyItem, propertyName, TYPE_NUM, value);
+        } else if (0 == strncmp(propertyName, AggregateStddevDIKey, aggregateStddevDiLen)) {
+            pinid = strtol(&propertyName[aggregateStddevDiLen], NULL, 10) - DI_FETCH_PORT_OFFSET;
+            if (pinid < 0 || pinid >= NUM_DI) {
+                continue;
+            }
+            bool value = false;
+
+            if (json_GetBoolValue(item, &value)) {
+                config[pinid].reportCond.aggregateStddev = value;
+            } else {
+                ret = false;
+            }
+            PropertyItems_AddItem(propertyItem, propertyName, TYPE_BOOL, value);
         }
     }
 
@@ -307,7 +381,9 @@ DI_FetchConfig_LoadFromJSON(DI_FetchConfig* me,
 
         for (int i = 0, n = vector_size(me->mFetchItems); i < n; ++i) {
             vector_add_last(me->mFetchItemPtrs, &curs);
-            TelemetryItems_AddDictionaryElem(curs->telemetryName, false);
+            curs->telemetryKey = TelemetryItems_AddDictionaryElem(
+                curs->telemetryName, TELEMETRY_TYPE_UINT32);
+            TelemetryItems_SetReportCondition(curs->telemetryKey, &curs->reportCond);
             ++curs;
         }
     }
@@ -33,15 +33,21 @@
 #include <stdbool.h>
 #endif
 
+typedef struct TelemetryKey	TelemetryKey;
+
 typedef struct DI_FetchItem {
     char        telemetryName[TELEMETRY_NAME_MAX_LEN + 1];  // telemetry name
-    uint32_t    intervalSec;    // periodic acquisition interval (in seconds)
+    uint32_t    intervalMs;     // periodic acquisition interval (in milliseconds)
+    uint32_t    phaseMs;        // acquisition phase in the interval (FETCH_PHASE_AUTO: automatic)
+    FetchCatchUpPolicy  catchUp;    // policy for the missed periods
     uint32_t    pinID;          // pin ID
     bool        isPulseCounter; // pulse counter(true) / polling(false)
     bool        isCountClear;   // whether to clear the counter
     bool        isPulseHigh;    // whether settlement as pulse when high(:1) or low(:0) level
     uint32_t    minPulseWidth;  // minimum length for settlement as pulse
     uint32_t    maxPulseCount;  // max pulse counter value
+    ReportCondition reportCond; // report-by-exception condition
+    const TelemetryKey* telemetryKey;   // key to add telemetry data item
 } DI_FetchItem;
 
 #endif  // _DI_FETCH_ITEM_H
@@ -74,5 +74,8 @@ DI_FetchTargets_Add(DI_FetchTargets* me, const DI_FetchItem* target)
 void
 DI_FetchTargets_Clear(DI_FetchTargets* me)
 {
-    vector_clear(me->mTargets);
+    // keep the storage for the next acquisition (vector_clear reallocates)
+    while (0 == vector_remove_last(me->mTargets)) {
+        ;
+    }
 }
@@ -106,11 +106,6 @@ DI_WatchConfig_LoadFromJSON(DI_WatchConfig* me,
     }
 
     if (0 != vector_size(me->mWatchItems)) {
-        DI_WatchItem*	curs = (DI_WatchItem*)vector_get_data(me->mWatchItems);
-
-        for (int i = 0, n = vector_size(me->mWatchItems); i < n; ++i) {
-            TelemetryItems_RemoveDictionaryElem(curs->telemetryName);
-        }
         vector_clear(me->mWatchItems);
         memset(me->version, 0, sizeof(me->version));
     }
@@ -168,7 +163,8 @@ DI_WatchConfig_LoadFromJSON(DI_WatchConfig* me,
         DI_WatchItem*	curs = (DI_WatchItem*)vector_get_data(me->mWatchItems);
 
         for (int i = 0, n = vector_size(me->mWatchItems); i < n; ++i) {
-            TelemetryItems_AddDictionaryElem(curs->telemetryName, false);
+            curs->telemetryKey = TelemetryItems_AddDictionaryElem(
+                curs->telemetryName, TELEMETRY_TYPE_UINT32);
             ++curs;
         }
     }
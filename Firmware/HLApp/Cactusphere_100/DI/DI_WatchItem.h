@@ -36,11 +36,14 @@
 #define TELEMETRY_NAME_MAX_LEN	32
 #endif
 
+typedef struct TelemetryKey	TelemetryKey;
+
 typedef struct DI_WatchItem {
     char        telemetryName[TELEMETRY_NAME_MAX_LEN + 1];  // telemetry name
     uint32_t    pinID;                  // pin ID
     bool        notifyChangeForHigh;   // whether the input's normal level isn't high
     bool        isCountClear;          // whether to clear the counter
+    const TelemetryKey* telemetryKey;  // key to add telemetry data item
 } DI_WatchItem;
 
 #endif  // _DI_WATCHITEM_H_
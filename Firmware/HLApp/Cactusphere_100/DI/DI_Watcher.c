@@ -24,15 +24,54 @@
 
 #include "DI_Watcher.h"
 
+#include <string.h>
+
 #include "DI_WatchItem.h"
+#include "InterCoreMsg.h"
 #include "LibDI.h"
+#include "SendRTApp.h"
 
 // DI_Watcher data members
 struct DI_Watcher {
     vector	mBody;         // vector of DI_WatchItemStat
     vector	mLastChanges;  // pointer vector of changed DI_WatchItemStat
+    bool	mIsStreaming;  // edges are streamed from RTApp (otherwise polling)
+    unsigned long	mEdges[NUM_DI];  // streamed edges to notify since last check
 };
 
+//
+// DI_Watcher's private procedure
+//
+static void
+DI_Watcher_SampleHandler(const InterCoreSample* samples, int count,
+    unsigned long dropped, void* context)
+{
+    // count the edges to the level which should be notified
+    DI_Watcher*	me = (DI_Watcher*)context;
+
+    for (int i = 0; i < count; i++, samples++) {
+        const DI_WatchItemStat*	curs;
+
+        if (samples->kind != INTERCORE_SAMPLE_DI_EDGE || samples->source >= NUM_DI) {
+            continue;
+        }
+        curs = (const DI_WatchItemStat*)vector_get_data(me->mBody);
+        for (int j = 0, n = vector_size(me->mBody); j < n; ++j, ++curs) {
+            if (curs->watchItem->pinID == samples->source
+            &&  curs->watchItem->notifyChangeForHigh == (0 != samples->value)) {
+                me->mEdges[samples->source]++;
+                break;
+            }
+        }
+    }
+    if (0 < dropped) {
+        // some edges are lost, notify all targets not to miss a change
+        for (int i = 0; i < NUM_DI; i++) {
+            me->mEdges[i]++;
+        }
+    }
+}
+
 // Initialization and cleanup
 DI_Watcher*
 DI_Watcher_New(void)
@@ -42,6 +81,8 @@ DI_Watcher_New(void)
     if (NULL != newObj) {
         newObj->mBody = vector_init(sizeof(DI_WatchItemStat));
         newObj->mLastChanges = vector_init(sizeof(DI_WatchItemStat*));
+        newObj->mIsStreaming = false;
+        memset(newObj->mEdges, 0, sizeof(newObj->mEdges));
         if (NULL == newObj->mBody || NULL == newObj->mLastChanges) {
             if (NULL != newObj->mBody) {
                 vector_destroy(newObj->mBody);
@@ -62,7 +103,9 @@ DI_Watcher_Init(DI_Watcher* me, vector watchItems)
 {
     // clean up old configuration and setting up monitoring with new configuration
     const DI_WatchItem*	curs;
+    unsigned long	pinMask = 0;
 
+    SendRTApp_SetSampleHandler(NULL, NULL);
     if (0 != vector_size(me->mBody)) {
         vector_clear(me->mBody);
         vector_clear(me->mLastChanges);
@@ -82,12 +125,29 @@ DI_Watcher_Init(DI_Watcher* me, vector watchItems)
         pseudo.watchItem      = curs++;
         pseudo.prevPulseCount = pseudo.currPulseCount = 0;
         vector_add_last(me->mBody, &pseudo);
+        pinMask |= 1UL << pseudo.watchItem->pinID;
+    }
+
+    // receive the edges from RTApp instead of polling the counters
+    // (if RTApp doesn't support it, keep polling)
+    memset(me->mEdges, 0, sizeof(me->mEdges));
+    me->mIsStreaming = false;
+    if (0 != pinMask) {
+        SendRTApp_SetSampleHandler(DI_Watcher_SampleHandler, me);
+    }
+    if (DI_Lib_SetSampleStream(pinMask) && 0 != pinMask) {
+        me->mIsStreaming = true;
+    } else {
+        SendRTApp_SetSampleHandler(NULL, NULL);
     }
 }
 
 void
 DI_Watcher_Destroy(DI_Watcher* me)
 {
+    if (me->mIsStreaming) {
+        SendRTApp_SetSampleHandler(NULL, NULL);
+    }
     vector_destroy(me->mBody);
     vector_destroy(me->mLastChanges);
     free(me);
@@ -116,7 +176,10 @@ DI_Watcher_DoWatch(DI_Watcher* me)
         // Check status change of contact input from the pulse counter value
         unsigned long	counterVal;
 
-        if (! DI_Lib_ReadPulseCount(curs->watchItem->pinID, &counterVal)) {
+        if (me->mIsStreaming) {
+            counterVal = curs->prevPulseCount + me->mEdges[curs->watchItem->pinID];
+            me->mEdges[curs->watchItem->pinID] = 0;
+        } else if (! DI_Lib_ReadPulseCount(curs->watchItem->pinID, &counterVal)) {
             // error!!
             continue;  // ignore that contact input
         }
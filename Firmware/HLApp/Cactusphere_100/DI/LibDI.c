@@ -25,6 +25,7 @@
 #include "LibDI.h"
 #include "SendRTApp.h"
 #include "DIDriveMsg.h"
+#include "InterCoreMsg.h"
 
 #include <signal.h>
 #include <string.h>
@@ -177,6 +178,44 @@ DI_Lib_ReadPinLevel(unsigned long pinId, unsigned int* outVal)
     return ret;
 }
 
+bool
+DI_Lib_SetSampleStream(unsigned long pinMask)
+{
+    unsigned char sendMessage[256];
+    DI_DriverMsg* msg = (DI_DriverMsg*)sendMessage;
+    int msgSize;
+    int ret = 0;
+
+    memset(msg, 0, sizeof(DI_DriverMsg));
+    msg->header.requestCode = DI_SET_SAMPLE_STREAM;
+    msg->header.messageLen = sizeof(DI_MsgSampleStream);
+    msg->body.sampleStream.pinMask = pinMask;
+    msgSize = (int)(sizeof(msg->header) + msg->header.messageLen);
+    if (! SendRTApp_SendMessageToRTCoreAndReadMessage((const unsigned char*)msg, msgSize,
+            (unsigned char*)&ret, sizeof(ret))) {
+        return false;
+    }
+
+    return (1 == ret);
+}
+
+bool
+DI_Lib_ReadStats(InterCoreStats* outStats, bool reset)
+{
+    unsigned char sendMessage[256];
+    DI_DriverMsg* msg = (DI_DriverMsg*)sendMessage;
+    int msgSize;
+
+    memset(msg, 0, sizeof(DI_DriverMsg));
+    msg->header.requestCode = DI_READ_STATS;
+    msg->header.messageLen = sizeof(DI_MsgStats);
+    msg->body.stats.reset = reset ? 1 : 0;
+    msgSize = (int)(sizeof(msg->header) + msg->header.messageLen);
+
+    return SendRTApp_SendMessageToRTCoreAndReadMessage((const unsigned char*)msg, msgSize,
+        (unsigned char*)outStats, sizeof(InterCoreStats));
+}
+
 bool
 DI_Lib_ReadRTAppVersion(char* rtAppVersion)
 {
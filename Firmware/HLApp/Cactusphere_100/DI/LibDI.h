@@ -52,6 +52,13 @@ extern bool DI_Lib_ReadLevels(int outLevels[NUM_DI]);
 // Get input level of specific pin
 extern bool DI_Lib_ReadPinLevel(unsigned long pinId, unsigned int* outVal);
 
+// Select the pins which stream their settled edges (bit n: pin n)
+extern bool DI_Lib_SetSampleStream(unsigned long pinMask);
+
+// Read the performance statistics of RTApp (and reset them)
+typedef struct InterCoreStats	InterCoreStats;
+extern bool DI_Lib_ReadStats(InterCoreStats* outStats, bool reset);
+
 // Get RTApp Version
 extern bool DI_Lib_ReadRTAppVersion(char* rtAppVersion);
 
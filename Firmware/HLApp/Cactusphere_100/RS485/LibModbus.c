@@ -166,6 +166,18 @@ ModbusDev* Libmodbus_GetAndConnectLib(int devID) {
     return modbusDevP;
 }
 
+// Get serial line settings of the device
+bool Libmodbus_GetSerialConfig(int devID, int* baud, uint8_t* parity, uint8_t* stop) {
+    ModbusDev* modbusDevP = ModbusDev_GetModbusDev(devID, sModbusVec);
+
+    if (modbusDevP == NULL) {
+        return false;
+    }
+    ModbusDev_GetSerialConfig(modbusDevP, baud, parity, stop);
+
+    return true;
+}
+
 bool Libmodbus_ReadRegister(ModbusDev* me, int regAddr, int funcCode, unsigned short* dst, int regCount) {
     return ModbusDev_ReadRegister(me, regAddr, funcCode, dst, regCount);
 }
@@ -177,3 +189,13 @@ bool Libmodbus_WriteRegister(ModbusDev* me, int regAddr, int funcCode, unsigned
 bool Libmodbus_GetRTAppVersion(char* rtAppVersion) {
     return ModbusDev_GetRTAppVersion(rtAppVersion);
 }
+
+// Set the poll plan of RTApp
+bool Libmodbus_SetPollPlan(const UART_PollEntry* entries, int entryNum) {
+    return ModbusDev_SetPollPlan(entries, entryNum);
+}
+
+// Read the performance statistics of RTApp
+bool Libmodbus_ReadRTAppStats(InterCoreStats* outStats, bool reset) {
+    return ModbusDev_ReadRTAppStats(outStats, reset);
+}
@@ -43,6 +43,9 @@ extern bool Libmodbus_LoadFromJSON(const json_value* json);
 // Connect
 extern ModbusDev* Libmodbus_GetAndConnectLib(int devID);
 
+// Get serial line settings of the device
+extern bool Libmodbus_GetSerialConfig(int devID, int* baud, uint8_t* parity, uint8_t* stop);
+
 // Read/Write register
 extern bool Libmodbus_ReadRegister(ModbusDev* me, int regAddr, int funcCode, unsigned short* dst, int regCount);
 extern bool Libmodbus_WriteRegister(ModbusDev* me, int regAddr, int funcCode, unsigned short* data);
@@ -50,4 +53,10 @@ extern bool Libmodbus_WriteRegister(ModbusDev* me, int regAddr, int funcCode, un
 // Get RTApp Version
 extern bool Libmodbus_GetRTAppVersion(char* rtAppVersion);
 
+// Set the poll plan of RTApp (no entry stops polling)
+extern bool Libmodbus_SetPollPlan(const UART_PollEntry* entries, int entryNum);
+
+// Read the performance statistics of RTApp (and reset them)
+extern bool Libmodbus_ReadRTAppStats(InterCoreStats* outStats, bool reset);
+
 #endif  // _LIBMODBUS_H_
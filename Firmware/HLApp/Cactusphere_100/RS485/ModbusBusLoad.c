@@ -0,0 +1,120 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "ModbusBusLoad.h"
+
+#include "LibModbus.h"
+#include "ModbusDevConfig.h"
+#include "ModbusPollPlan.h"
+
+// frame lengths of reading registers
+#define MODBUS_RTU_READ_REQ_LENGTH	8   // slave ID + function + address + count + CRC
+#define MODBUS_RTU_READ_RSP_LENGTH	5   // slave ID + function + byte count + CRC (w/o registers)
+
+// bus timing (in microseconds)
+#define MODBUS_RTU_FIXED_SILENCE_US	1750    // inter-frame silence above 19200bps
+#define MODBUS_RTU_TURNAROUND_US	5000    // response delay of a slave (assumed)
+#define MODBUS_RTU_TIMEOUT_US		400000  // response timeout of the RTApp
+
+//
+// ModbusBusLoad's private procedure/method
+//
+static uint64_t
+ModbusBusLoad_CharsToUs(uint32_t chars, uint32_t charBits, uint32_t baud)
+{
+    return ((uint64_t)chars * charBits * 1000000 + baud - 1) / baud;
+}
+
+static uint64_t
+ModbusBusLoad_PerMilleOf(uint64_t busyUs, uint32_t intervalMs)
+{
+    // in 1/1000 per mille, not to drop short transactions
+    return busyUs * 1000 / intervalMs;
+}
+
+// Estimate the bus load of fetch items (vector of ModbusFetchItem*)
+bool
+ModbusBusLoad_Estimate(vector fetchItemPtrs, ModbusBusLoad* load)
+{
+    // Estimate the bus time of each transaction of the poll plan from its
+    // frame lengths, the character time of the device's serial settings,
+    // the inter-frame silence (3.5 characters) and the response delay, and
+    // sum up its ratio to the interval. The worst case is the one where
+    // every request waits for the response timeout.
+    ModbusPollPlan*	plan = ModbusPollPlan_New();
+    vector	transactions;
+    uint64_t	utilization = 0;
+    uint64_t	timeoutUtilization = 0;
+
+    load->transactionCount   = 0;
+    load->utilization        = 0;
+    load->timeoutUtilization = 0;
+    if (NULL == plan) {
+        return false;
+    }
+    if (! ModbusPollPlan_Compile(plan, fetchItemPtrs)) {
+        ModbusPollPlan_Destroy(plan);
+        return false;
+    }
+
+    transactions = ModbusPollPlan_GetTimerTargets(plan);
+    for (int i = 0, n = vector_size(transactions); i < n; ++i) {
+        const ModbusPollTransaction*	transaction;
+        int	baud;
+        uint8_t	parity, stop;
+        uint32_t	charBits;
+        uint64_t	silenceUs, requestUs, responseUs;
+
+        vector_get_at(&transaction, transactions, i);
+        if (! Libmodbus_GetSerialConfig((int)transaction->devID, &baud, &parity, &stop)
+            || 0 >= baud) {
+            continue;  // not on the bus
+        }
+
+        // start bit + data bits + parity bit + stop bits
+        charBits = 1 + 8 + (PARITY_NONE != parity ? 1 : 0) + stop;
+        silenceUs = (19200 < baud)
+            ? MODBUS_RTU_FIXED_SILENCE_US
+            : ModbusBusLoad_CharsToUs(7, charBits, (uint32_t)baud * 2);  // 3.5 chars
+        requestUs  = ModbusBusLoad_CharsToUs(
+            MODBUS_RTU_READ_REQ_LENGTH, charBits, (uint32_t)baud);
+        responseUs = ModbusBusLoad_CharsToUs(
+            MODBUS_RTU_READ_RSP_LENGTH + transaction->regCount * 2, charBits, (uint32_t)baud);
+
+        utilization += ModbusBusLoad_PerMilleOf(
+            silenceUs + requestUs + MODBUS_RTU_TURNAROUND_US + responseUs + silenceUs,
+            transaction->intervalMs);
+        timeoutUtilization += ModbusBusLoad_PerMilleOf(
+            silenceUs + requestUs + MODBUS_RTU_TIMEOUT_US,
+            transaction->intervalMs);
+        load->transactionCount++;
+    }
+    ModbusPollPlan_Destroy(plan);
+
+    load->utilization = (uint32_t)((utilization + 999) / 1000);
+    load->timeoutUtilization = (uint32_t)((timeoutUtilization + 999) / 1000);
+
+    return true;
+}
@@ -0,0 +1,53 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _MODBUS_BUS_LOAD_H_
+#define _MODBUS_BUS_LOAD_H_
+
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+#ifndef CONTAINERS_VECTOR_H
+#include "vector.h"
+#endif
+
+// max utilization of the RS485 bus to be admitted (in per mille)
+#define MODBUS_BUS_UTILIZATION_MAX	1000
+
+// estimated load of the RS485 bus (in per mille of the bus time)
+typedef struct ModbusBusLoad {
+    uint32_t    transactionCount;   // number of bus transactions per plan
+    uint32_t    utilization;        // when all the devices respond
+    uint32_t    timeoutUtilization; // when no device responds
+} ModbusBusLoad;
+
+// Estimate the bus load of fetch items (vector of ModbusFetchItem*)
+extern bool	ModbusBusLoad_Estimate(vector fetchItemPtrs, ModbusBusLoad* load);
+
+#endif  // _MODBUS_BUS_LOAD_H_
@@ -33,6 +33,7 @@
 
 #include "json.h"
 #include "LibModbus.h"
+#include "ModbusBusLoad.h"
 #include "ModbusFetchConfig.h"
 #include "PropertyItems.h"
 
@@ -42,6 +43,37 @@ typedef struct ModbusConfigMgr {
 
 static ModbusConfigMgr sModbusConfigMgr;
 
+// Estimate the bus load and report it
+static bool
+ModbusConfigMgr_CheckBusLoad(vector item)
+{
+    ModbusBusLoad load;
+
+    if (!ModbusBusLoad_Estimate(
+        ModbusFetchConfig_GetFetchItemPtrs(sModbusConfigMgr.fetchConfig), &load)) {
+        return true;
+    }
+
+    // report in percent
+    PropertyItems_AddItem(item, "ModbusBusUtilization", TYPE_NUM,
+        (load.utilization + 9) / 10);
+    PropertyItems_AddItem(item, "ModbusBusUtilizationTimeout", TYPE_NUM,
+        (load.timeoutUtilization + 9) / 10);
+
+    if (load.timeoutUtilization > MODBUS_BUS_UTILIZATION_MAX) {
+        Log_Debug("WARNING: RS485 bus will be over-subscribed on timeouts (%u/1000)\n",
+            load.timeoutUtilization);
+    }
+    if (load.utilization > MODBUS_BUS_UTILIZATION_MAX) {
+        // the intervals will be stretched
+        Log_Debug("ModbusTelemetryConfig over-subscribes RS485 bus (%u/1000)!\n",
+            load.utilization);
+        return false;
+    }
+
+    return true;
+}
+
 // Initialization and cleanup
 void
 ModbusConfigMgr_Initialize(void)
@@ -67,6 +99,7 @@ ModbusConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
     json_value* desiredObj = NULL;
     json_value* modbusConfObj = NULL;
     json_value* telemetryConfObj = NULL;
+    bool changed = false;
 
     desiredObj = json_GetKeyJson("desired", jsonObj);
     if (desiredObj == NULL) {
@@ -87,6 +120,7 @@ ModbusConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
             modbusConfObj = json_GetKeyJson("value", modbusConfObj);
         }
         PropertyItems_AddItem(item, "ModbusDevConfig", TYPE_STR, modbusConfObj->u.string.ptr);
+        changed = true;
         modbusConfObj = json_parse(modbusConfObj->u.string.ptr, modbusConfObj->u.string.length);
         if (modbusConfObj != NULL) {
             Libmodbus_ModbusDevClear();
@@ -106,6 +140,7 @@ ModbusConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
             telemetryConfObj = json_GetKeyJson("value", telemetryConfObj);
         }
         PropertyItems_AddItem(item, "ModbusTelemetryConfig", TYPE_STR, telemetryConfObj->u.string.ptr);
+        changed = true;
         telemetryConfObj = json_parse(telemetryConfObj->u.string.ptr, telemetryConfObj->u.string.length);
         if (telemetryConfObj != NULL) {
             if (!ModbusFetchConfig_LoadFromJSON(sModbusConfigMgr.fetchConfig, telemetryConfObj, "1.0")) {
@@ -118,6 +153,11 @@ ModbusConfigMgr_LoadAndApplyIfChanged(const unsigned char* payload,
         }
     }
 
+    // admission control of the bus load with the devices and the items
+    if (changed && !ModbusConfigMgr_CheckBusLoad(item)) {
+        ret = ILLEGAL_PROPERTY;
+    }
+
 end:
     return ret;
 }
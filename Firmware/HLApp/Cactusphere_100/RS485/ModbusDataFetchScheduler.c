@@ -24,126 +24,397 @@
 
 #include <string.h>
 
+#include <applibs/log.h>
+
 #include "ModbusDataFetchScheduler.h"
 
 #include "LibModbus.h"
 #include "ModbusFetchItem.h"
-#include "ModbusFetchTargets.h"
+#include "ModbusPollPlan.h"
 #include "ModbusDevConfig.h"
-#include "StringBuf.h"
+#include "FetchTimers.h"
+#include "InterCoreMsg.h"
+#include "SendRTApp.h"
 #include "TelemetryItems.h"
 
 #define  MODBUS_ONESHOT_COMMAND_PARAM_NUM 4
 
+// time budget of acquisition per schedule (in milliseconds)
+// (critical transactions are acquired beyond the budget)
+#define  MODBUS_SCHEDULE_BUDGET_MS 100
+
 typedef struct ModbusDataFetchScheduler {
     DataFetchSchedulerBase	Super;
 
     // data member
-    ModbusFetchTargets*	mFetchTargets;  // acquisition targets of Modbus RTU
+    ModbusPollPlan*	mPollPlan;  // acquisition plan of Modbus RTU
+    uint64_t	mLatenessStart;     // time when the lateness statistics started
+    bool	mIsAutonomous;          // RTApp polls by the uploaded plan
+    vector	mNoTimerTargets;        // (empty, while RTApp polls)
+    unsigned short	mAutoVal[UART_POLL_PLAN_MAX][MODBUS_POLL_MAX_REGS];  // registers polled by RTApp
+    bool	mAutoReady[UART_POLL_PLAN_MAX];  // mAutoVal has been read up to the last register
+    unsigned short	mAutoRecv[UART_POLL_PLAN_MAX][MODBUS_POLL_MAX_REGS];  // registers being received
+    unsigned char	mAutoNext[UART_POLL_PLAN_MAX];  // offset of the register to receive next
 } ModbusDataFetchScheduler;
 
+// mAutoNext while waiting for the first register of the next transaction
+#define AUTO_NEXT_NONE	0xFF
+
 //
 // DataFetchScheduler's private procedure/method
 //
 // Callback procedure of FetchTimers
 static void
-ModbusFetchTimerCallback(void* arg, const FetchItemBase* fetchTarget)
+ModbusFetchTimerCallback(void* arg, const FetchItemBase* fetchTarget,
+    uint64_t expiryMs)
 {
+    // the target is a transaction of the poll plan, which is released at
+    // the scheduled expiration (so the lateness includes the delay of the
+    // timer notification)
     ModbusDataFetchScheduler* scheduler = (ModbusDataFetchScheduler*)arg;
 
-    ModbusFetchTargets_Add(
-        scheduler->mFetchTargets, (const ModbusFetchItem*)fetchTarget);
+    ModbusPollPlan_SetDue(scheduler->mPollPlan, fetchTarget, expiryMs);
 }
 
-// Virtual method
 static void
-ModbusDataFetchScheduler_DoDestroy(DataFetchSchedulerBase* me)
+ModbusDataFetchScheduler_AddLateness(ModbusDataFetchScheduler* me, uint64_t now)
 {
-    ModbusDataFetchScheduler*	self = (ModbusDataFetchScheduler*)me;
+    // add the max lateness of each item per statistics period
+    vector	transactions = ModbusPollPlan_GetTimerTargets(me->mPollPlan);
 
-    ModbusFetchTargets_Destroy(self->mFetchTargets);
+    if (now - me->mLatenessStart < FETCH_STATS_PERIOD_MS) {
+        return;
+    }
+    for (int i = 0, n = vector_size(transactions); i < n; ++i) {
+        const ModbusPollTransaction*	transaction;
+        const ModbusFetchItem* const*	fiCurs;
+
+        vector_get_at(&transaction, transactions, i);
+        fiCurs = ModbusPollPlan_GetFetchItems(me->mPollPlan, transaction);
+        for (int j = 0, m = transaction->itemCount; j < m; ++j) {
+            const ModbusFetchItem* item = *fiCurs++;
+
+            TelemetryItems_AddUInt32(me->Super.mTelemetryItems,
+                item->latenessKey, transaction->maxLatenessMs);
+        }
+    }
+    ModbusPollPlan_ResetLateness(me->mPollPlan);
+    me->mLatenessStart = now;
 }
 
 static void
-ModbusDataFetchScheduler_ClearFetchTargets(DataFetchSchedulerBase* me)
+ModbusDataFetchScheduler_AddValue(DataFetchSchedulerBase* me,
+    const ModbusFetchItem* item, const unsigned short* readVal)
 {
-    ModbusDataFetchScheduler* self = (ModbusDataFetchScheduler*)me;
+    // convert the read registers and add as telemetry item
+    unsigned long tmpVal  = 0;
+    if (item->regCount == 2) {
+        tmpVal = (unsigned long)((readVal[0] << 16) + readVal[1]);
+    } else {
+        tmpVal = readVal[0];
+    }
+
+    if (item->asFloat) {
+        double fVal = tmpVal;
+
+        fVal += item->offset;
+        if (item->multiplier != 0) {
+            fVal *= item->multiplier;
+        }
+        if (item->devider != 0) {
+            fVal /= item->devider;
+        }
+        TelemetryItems_AddDouble(me->mTelemetryItems,
+            item->telemetryKey, fVal);
+    } else {
+        unsigned long ulVal = tmpVal;
+
+        ulVal += item->offset;
+        if (item->multiplier != 0) {
+            ulVal *= item->multiplier;
+        }
+        if (item->devider != 0) {
+            ulVal /= item->devider;
+        }
 
-    ModbusFetchTargets_Clear(self->mFetchTargets);
+        TelemetryItems_AddInt32(me->mTelemetryItems,
+            item->telemetryKey, (int32_t)ulVal);
+    }
 }
 
+// Handler of the samples of the registers polled by RTApp
+// (field bus thread)
 static void
-ModbusDataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
+ModbusDataFetchScheduler_SampleHandler(const InterCoreSample* samples,
+    int count, unsigned long dropped, void* context)
 {
-    ModbusDataFetchScheduler* self = (ModbusDataFetchScheduler*)me;
-    vector	devIDs;
+    ModbusDataFetchScheduler*	me = (ModbusDataFetchScheduler*)context;
+    bool	isReady = false;
 
-    devIDs = ModbusFetchTargets_GetDevIDs(self->mFetchTargets);
-    if (!vector_is_empty(devIDs)) {
-        unsigned long* devIDCurs = (unsigned long*)vector_get_data(devIDs);
+    if (0 != dropped) {
+        // the registers received so far may lack the dropped ones
+        Log_Debug("WARNING: %lu samples of Modbus polling dropped\n", dropped);
+        memset(me->mAutoNext, AUTO_NEXT_NONE, sizeof(me->mAutoNext));
+    }
 
-        for (int i = 0, n = vector_size(devIDs); i < n; i++) {
-            unsigned long	devID = *devIDCurs++;
-            vector	fetchItems = ModbusFetchTargets_GetFetchItems(
-                self->mFetchTargets, devID);
-            const ModbusFetchItem** fiCurs =
-                (const ModbusFetchItem**)vector_get_data(fetchItems);
+    // The registers of a transaction may span the batches, so they are
+    // collected in mAutoRecv and published to mAutoVal only when all of
+    // them have arrived in sequence (not to mix the values of two polls).
+    for (int i = 0; i < count; ++i) {
+        const InterCoreSample*	sample = &samples[i];
+        unsigned int	entry  = sample->source >> 8;
+        unsigned int	offset = sample->source & 0xFF;
 
-            ModbusDev* modbusdev = Libmodbus_GetAndConnectLib((int)devID);
+        if (entry >= UART_POLL_PLAN_MAX) {
+            continue;
+        }
+        if (INTERCORE_SAMPLE_MODBUS_ERROR == sample->kind) {
+            me->mAutoNext[entry] = AUTO_NEXT_NONE;  // (error is regarded as no value)
+            continue;
+        }
+        if (INTERCORE_SAMPLE_MODBUS_REG != sample->kind
+            || offset >= MODBUS_POLL_MAX_REGS) {
+            continue;
+        }
+        if (0 == offset) {
+            me->mAutoNext[entry] = 0;  // (re)start of a transaction
+        }
+        if (offset != me->mAutoNext[entry]) {
+            me->mAutoNext[entry] = AUTO_NEXT_NONE;  // out of sequence, discard
+            continue;
+        }
+        me->mAutoRecv[entry][offset] = (unsigned short)sample->value;
+        me->mAutoNext[entry]++;
+        if (sample->value & INTERCORE_SAMPLE_LAST_REG) {
+            memcpy(me->mAutoVal[entry], me->mAutoRecv[entry],
+                (offset + 1) * sizeof(unsigned short));
+            me->mAutoNext[entry]  = AUTO_NEXT_NONE;
+            me->mAutoReady[entry] = true;
+            isReady = true;
+        }
+    }
+
+    if (isReady) {
+        // acquire at the next turn of the event loop, not here; the handler
+        // may be called while a synchronous request of Schedule() waits
+        FetchTimers_Resume(me->Super.mFetchTimers);
+    }
+}
 
-            if (modbusdev == NULL) {
-                continue;
+// Upload the poll plan to RTApp, if all the transactions can be polled
+// by RTApp (fixed interval reading of holding/input registers);
+// otherwise stop RTApp's polling and poll by the fetch timers
+static bool
+ModbusDataFetchScheduler_StartAutonomous(ModbusDataFetchScheduler* me)
+{
+    vector	transactions = ModbusPollPlan_GetTimerTargets(me->mPollPlan);
+    UART_PollEntry	entries[UART_POLL_PLAN_MAX];
+    uint32_t	phases[UART_POLL_PLAN_MAX];
+    int	entryNum = vector_size(transactions);
+    bool	isEligible = (0 < entryNum && entryNum <= UART_POLL_PLAN_MAX);
+
+    for (int i = 0; isEligible && i < entryNum; ++i) {
+        const ModbusPollTransaction*	transaction;
+        UART_PollEntry*	entry = &entries[i];
+        int	baud;
+
+        vector_get_at(&transaction, transactions, i);
+        if ((FC_READ_HOLDING_REGISTER != transaction->funcCode
+                && FC_READ_INPUT_REGISTERS != transaction->funcCode)
+            || 0 != transaction->intervalMaxMs
+            || FETCH_CATCHUP_SKIP != transaction->catchUp  // (RTApp keeps the phase)
+            || transaction->regCount > UART_POLL_REGS_MAX
+            || ! Libmodbus_GetSerialConfig((int)transaction->devID,
+                &baud, &entry->parity, &entry->stop)) {
+            isEligible = false;
+            break;
+        }
+        entry->periodMs = (0 < transaction->intervalMs) ?
+            transaction->intervalMs : FETCH_INTERVAL_MS_MIN;
+        entry->phaseMs  = transaction->phaseMs;
+        entry->baudRate = (uint32_t)baud;
+        entry->regAddr  = (uint16_t)transaction->regAddr;
+        entry->regCount = (uint16_t)transaction->regCount;
+        entry->devId    = (uint8_t)transaction->devID;
+        entry->funcCode = (uint8_t)transaction->funcCode;
+    }
+    for (int i = 0; isEligible && i < entryNum; ++i) {
+        // the first polling at the phase as FetchTimers does (the entries
+        // without explicit phase are spread evenly over the interval)
+        const UART_PollEntry*	entry = &entries[i];
+        uint32_t	phase = entry->phaseMs;
+
+        if (FETCH_PHASE_AUTO == phase) {
+            int	order = 0;
+            int	count = 0;
+
+            for (int j = 0; j < entryNum; ++j) {
+                if (FETCH_PHASE_AUTO == entries[j].phaseMs
+                    && entries[j].periodMs == entry->periodMs) {
+                    if (j < i) {
+                        order++;
+                    }
+                    count++;
+                }
             }
+            phase = (uint32_t)((uint64_t)entry->periodMs * order / count);
+        } else {
+            phase %= entry->periodMs;
+        }
+        phases[i] = phase;
+    }
+    for (int i = 0; isEligible && i < entryNum; ++i) {
+        entries[i].phaseMs = phases[i];
+    }
 
-            for (int j = 0, m = vector_size(fetchItems); j < m; ++j) {
-                const ModbusFetchItem* item = *fiCurs++;
-                unsigned short readVal[2] = { 0 };
+    // the batches of the previous plan are dropped until RTApp replies
+    SendRTApp_SetSampleHandler(NULL, NULL);
+    memset(me->mAutoReady, 0, sizeof(me->mAutoReady));
+    memset(me->mAutoNext, AUTO_NEXT_NONE, sizeof(me->mAutoNext));
+    if (! isEligible) {
+        Libmodbus_SetPollPlan(NULL, 0);
+        return false;
+    }
+    if (! Libmodbus_SetPollPlan(entries, entryNum)) {
+        return false;  // (RTApp doesn't support it)
+    }
+    SendRTApp_SetSampleHandler(ModbusDataFetchScheduler_SampleHandler, me);
 
-                if (!Libmodbus_ReadRegister(modbusdev, (int)item->regAddr, (int)item->funcCode, readVal, (int)item->regCount)) {
-                    // error!
-                    continue;
-                }
+    return true;
+}
 
-                unsigned long tmpVal  = 0;
-                if (item->regCount == 2) {
-                    tmpVal = (unsigned long)((readVal[0] << 16) + readVal[1]);
-                } else {
-                    tmpVal = readVal[0];
-                }
+// Virtual method
+static bool
+ModbusDataFetchScheduler_ReadRTAppStats(
+    DataFetchSchedulerBase* me, InterCoreStats* outStats)
+{
+    return Libmodbus_ReadRTAppStats(outStats, true);
+}
 
-                if (item->asFloat) {
-                    double fVal = tmpVal;
+static void
+ModbusDataFetchScheduler_DoDestroy(DataFetchSchedulerBase* me)
+{
+    ModbusDataFetchScheduler*	self = (ModbusDataFetchScheduler*)me;
 
-                    fVal += item->offset;
-                    if (item->multiplier != 0) {
-                        fVal *= item->multiplier;
-                    }
-                    if (item->devider != 0) {
-                        fVal /= item->devider;
-                    }
-                    StringBuf_AppendByPrintf(me->mStringBuf, "%f", fVal);
-                } else {
-                    unsigned long ulVal = tmpVal;
+    if (self->mIsAutonomous) {
+        SendRTApp_SetSampleHandler(NULL, NULL);
+    }
+    vector_destroy(self->mNoTimerTargets);
+    ModbusPollPlan_Destroy(self->mPollPlan);
+}
 
-                    ulVal += item->offset;
-                    if (item->multiplier != 0) {
-                        ulVal *= item->multiplier;
-                    }
-                    if (item->devider != 0) {
-                        ulVal /= item->devider;
-                    }
+static void
+ModbusDataFetchScheduler_DoInit(DataFetchSchedulerBase* me, vector fetchItemPtrs)
+{
+    // compile the poll plan of the configuration
+    ModbusDataFetchScheduler*	self = (ModbusDataFetchScheduler*)me;
 
-                    StringBuf_AppendByPrintf(me->mStringBuf, "%ld", ulVal);
-                }
+    if (! ModbusPollPlan_Compile(self->mPollPlan, fetchItemPtrs)) {
+        Log_Debug("ERROR: failed to compile Modbus poll plan\n");
+    }
+    self->mLatenessStart = 0;  // (FetchTimers' time restarts)
+    self->mIsAutonomous = ModbusDataFetchScheduler_StartAutonomous(self);
+}
 
-                TelemetryItems_Add(me->mTelemetryItems,
-                    item->telemetryName, StringBuf_GetStr(me->mStringBuf));
-                StringBuf_Clear(me->mStringBuf);
-            }
+static vector
+ModbusDataFetchScheduler_GetTimerTargets(
+    DataFetchSchedulerBase* me, vector fetchItemPtrs)
+{
+    // a timer per transaction of the poll plan
+    // (no timer while RTApp polls)
+    ModbusDataFetchScheduler*	self = (ModbusDataFetchScheduler*)me;
+
+    if (self->mIsAutonomous) {
+        return self->mNoTimerTargets;
+    }
+    return ModbusPollPlan_GetTimerTargets(self->mPollPlan);
+}
+
+static void
+ModbusDataFetchScheduler_DoScheduleAutonomous(ModbusDataFetchScheduler* me)
+{
+    // add the values of the transactions polled by RTApp
+    // (the lateness is measured only while polling by the fetch timers)
+    vector	transactions = ModbusPollPlan_GetTimerTargets(me->mPollPlan);
+
+    for (int i = 0, n = vector_size(transactions); i < n; ++i) {
+        const ModbusPollTransaction*	transaction;
+        const ModbusFetchItem* const*	fiCurs;
+
+        if (! me->mAutoReady[i]) {
+            continue;
+        }
+        me->mAutoReady[i] = false;
+        vector_get_at(&transaction, transactions, i);
+        fiCurs = ModbusPollPlan_GetFetchItems(me->mPollPlan, transaction);
+        for (int j = 0, m = transaction->itemCount; j < m; ++j) {
+            const ModbusFetchItem* item = *fiCurs++;
+
+            ModbusDataFetchScheduler_AddValue(&me->Super, item,
+                &me->mAutoVal[i][item->regAddr - transaction->regAddr]);
         }
     }
 }
 
+static void
+ModbusDataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
+{
+    // Acquire the due transactions in the order of priority class and
+    // deadline within the time budget. The rest is left in the queue and
+    // continued at the next turn of the event loop, so that the other
+    // events aren't blocked by an over-subscribed bus.
+    ModbusDataFetchScheduler* self = (ModbusDataFetchScheduler*)me;
+    ModbusDev*	modbusdev = NULL;
+    uint32_t	lastDevID = 0;  // (0 isn't valid ID)
+    uint64_t	start = FetchTimers_GetNow(me->mFetchTimers);
+    uint64_t	now = start;
+    const ModbusPollTransaction*	transaction;
+
+    if (self->mIsAutonomous) {
+        ModbusDataFetchScheduler_DoScheduleAutonomous(self);
+        return;
+    }
+    while (NULL != (transaction = ModbusPollPlan_NextDue(self->mPollPlan, now))) {
+        const ModbusFetchItem* const*	fiCurs =
+            ModbusPollPlan_GetFetchItems(self->mPollPlan, transaction);
+        unsigned short readVal[MODBUS_POLL_MAX_REGS] = { 0 };
+        bool	isRead;
+
+        if (MODBUS_PRIORITY_CRITICAL != transaction->priority
+            && now - start >= MODBUS_SCHEDULE_BUDGET_MS) {
+            FetchTimers_Resume(me->mFetchTimers);
+            break;
+        }
+
+        if (transaction->devID != lastDevID) {
+            modbusdev = Libmodbus_GetAndConnectLib((int)transaction->devID);
+            lastDevID = transaction->devID;
+        }
+        isRead = (modbusdev != NULL
+            && Libmodbus_ReadRegister(modbusdev, (int)transaction->regAddr,
+                (int)transaction->funcCode, readVal, (int)transaction->regCount));
+        ModbusPollPlan_RemoveDue(self->mPollPlan, now);
+        now = FetchTimers_GetNow(me->mFetchTimers);
+        if (!isRead) {
+            // error!
+            continue;
+        }
+        if (ModbusPollPlan_AdaptInterval(self->mPollPlan, transaction, readVal)) {
+            FetchTimers_SetInterval(me->mFetchTimers,
+                (const FetchItemBase*)transaction, transaction->currentIntervalMs);
+        }
+
+        for (int j = 0, m = transaction->itemCount; j < m; ++j) {
+            const ModbusFetchItem* item = *fiCurs++;
+
+            ModbusDataFetchScheduler_AddValue(me, item,
+                &readVal[item->regAddr - transaction->regAddr]);
+        }
+    }
+
+    ModbusDataFetchScheduler_AddLateness(self, now);
+}
+
 void ModbusOneshotcommand(const unsigned char* payload, size_t size, char* response) {
     const char DevIDkey[]           = "devID";
     const char RegisterAddrKey[]    = "registerAddr";
@@ -232,18 +503,29 @@ ModbusDataFetchScheduler_New(void)
             super, ModbusFetchTimerCallback, MODBUS_RTU)) {
             goto err;
         }
-        newObj->mFetchTargets = ModbusFetchTargets_New();
-        if (NULL == newObj->mFetchTargets) {
+        newObj->mPollPlan = ModbusPollPlan_New();
+        if (NULL == newObj->mPollPlan) {
             goto err_delete_super;
         }
+        newObj->mNoTimerTargets = vector_init(sizeof(FetchItemBase*));
+        if (NULL == newObj->mNoTimerTargets) {
+            goto err_delete_pollPlan;
+        }
+        newObj->mLatenessStart = 0;
+        newObj->mIsAutonomous  = false;
+        memset(newObj->mAutoReady, 0, sizeof(newObj->mAutoReady));
+        memset(newObj->mAutoNext, AUTO_NEXT_NONE, sizeof(newObj->mAutoNext));
     }
 
     super->DoDestroy = ModbusDataFetchScheduler_DoDestroy;
-//	super->DoInit    = ModbusDataFetchScheduler_DoInit;  // don't override
-    super->ClearFetchTargets = ModbusDataFetchScheduler_ClearFetchTargets;
+    super->DoInit    = ModbusDataFetchScheduler_DoInit;
+    super->GetTimerTargets   = ModbusDataFetchScheduler_GetTimerTargets;
     super->DoSchedule        = ModbusDataFetchScheduler_DoSchedule;
+    super->ReadRTAppStats    = ModbusDataFetchScheduler_ReadRTAppStats;
 
     return super;
+err_delete_pollPlan:
+    ModbusPollPlan_Destroy(newObj->mPollPlan);
 err_delete_super:
     DataFetchScheduler_Destroy(super);
 err:
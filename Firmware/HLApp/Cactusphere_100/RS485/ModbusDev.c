@@ -91,6 +91,12 @@ ModbusDev_Connect(ModbusDev* me) {
     return ModbusDevRTU_Connect(me->ctx);
 }
 
+// Get serial line settings
+void
+ModbusDev_GetSerialConfig(const ModbusDev* me, int* baud, uint8_t* parity, uint8_t* stop) {
+    ModbusDevRTU_GetSerialConfig(me->ctx, baud, parity, stop);
+}
+
 // Read status/register
 bool 
 ModbusDev_ReadRegister(ModbusDev* me, int regAddr, int funcCode, unsigned short* dst, int regCount) {
@@ -108,3 +114,15 @@ bool
 ModbusDev_GetRTAppVersion(char* rtAppVersion) {
     return ModbusDevRTU_GetRTAppVersion(rtAppVersion);
 }
+
+// Set the poll plan of RTApp
+bool
+ModbusDev_SetPollPlan(const UART_PollEntry* entries, int entryNum) {
+    return ModbusDevRTU_SetPollPlan(entries, entryNum);
+}
+
+// Read the performance statistics of RTApp
+bool
+ModbusDev_ReadRTAppStats(InterCoreStats* outStats, bool reset) {
+    return ModbusDevRTU_ReadRTAppStats(outStats, reset);
+}
@@ -29,6 +29,8 @@
 
 #include "json.h"
 #include "vector.h"
+#include "InterCoreMsg.h"
+#include "UartDriveMsg.h"
 
 typedef struct ModbusDev ModbusDev;
 
@@ -45,6 +47,9 @@ extern ModbusDev* ModbusDev_GetModbusDev(int devID, vector modbusDevVec);
 // Connect
 extern bool ModbusDev_Connect(ModbusDev* me);
 
+// Get serial line settings
+extern void ModbusDev_GetSerialConfig(const ModbusDev* me, int* baud, uint8_t* parity, uint8_t* stop);
+
 // Read status/register
 extern bool ModbusDev_ReadRegister(ModbusDev* me, int regAddr, int funcCode, unsigned short* dst, int regCount);
 
@@ -53,4 +58,10 @@ extern bool ModbusDev_WriteRegister(ModbusDev* me, int regAddr, int funcCode, ui
 
 // Get RTApp Version
 extern bool ModbusDev_GetRTAppVersion(char* rtAppVersion);
+
+// Set the poll plan of RTApp (no entry stops polling)
+extern bool ModbusDev_SetPollPlan(const UART_PollEntry* entries, int entryNum);
+
+// Read the performance statistics of RTApp (and reset them)
+extern bool ModbusDev_ReadRTAppStats(InterCoreStats* outStats, bool reset);
 #endif  // _MODBUS_DEV_H_
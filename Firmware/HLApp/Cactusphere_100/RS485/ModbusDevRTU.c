@@ -145,7 +145,9 @@ ModbusDevRTU_ReadRegister(ModbusCtx* me, int regAddr, int function, unsigned sho
 
     memcpy(msg->body.writeAndReadReq.writeData, req, (size_t)req_length);
     msg->body.writeAndReadReq.writeLen = (uint16_t)req_length;
-    msg->body.writeAndReadReq.readLen = 7;
+    // slave ID + function + byte count + registers + CRC
+    msg->body.writeAndReadReq.readLen =
+        (uint16_t)(me->header_length + 2 + length * 2 + me->checksum_length);
 
     msg->header.messageLen = sizeof(msg->body.writeAndReadReq.writeLen)
         + sizeof(msg->body.writeAndReadReq.readLen)
@@ -220,6 +222,14 @@ ModbusDevRTU_Connect(ModbusCtx* me) {
     return true;
 }
 
+// Get serial line settings
+void
+ModbusDevRTU_GetSerialConfig(const ModbusCtx* me, int* baud, uint8_t* parity, uint8_t* stop) {
+    *baud = me->baud;
+    *parity = me->parity;
+    *stop = me->stop;
+}
+
 // Write 2byte
 bool
 ModbusDevRTU_WriteRegister(ModbusCtx* me, int regAddr, int funcCode, unsigned short value) {
@@ -274,3 +284,47 @@ ModbusDevRTU_GetRTAppVersion(char* rtAppVersion) {
 
     return ret;
 }
+
+// Set the poll plan of RTApp
+bool
+ModbusDevRTU_SetPollPlan(const UART_PollEntry* entries, int entryNum) {
+    unsigned char sendMessage[sizeof(UART_DriverMsg)];
+    int readMessage = 0;
+    UART_DriverMsg* msg = (UART_DriverMsg*)sendMessage;
+    int msgSize;
+
+    if (entryNum < 0 || entryNum > UART_POLL_PLAN_MAX) {
+        return false;
+    }
+    msg->header.requestCode = UART_REQ_SET_POLL_PLAN;
+    msg->header.messageLen = (uint32_t)(sizeof(msg->body.pollPlan.entryNum)
+        + sizeof(UART_PollEntry) * (size_t)entryNum);
+    msg->body.pollPlan.entryNum = (uint32_t)entryNum;
+    if (0 < entryNum) {
+        memcpy(msg->body.pollPlan.entries, entries, sizeof(UART_PollEntry) * (size_t)entryNum);
+    }
+    msgSize = (int)(sizeof(msg->header) + msg->header.messageLen);
+
+    // (RTApp which doesn't support the poll plan rejects it)
+    if (! SendRTApp_SendMessageToRTCoreAndReadMessage((const unsigned char*)msg, msgSize,
+            (unsigned char*)&readMessage, sizeof(readMessage))) {
+        return false;
+    }
+    return (readMessage == 1);
+}
+
+// Read the performance statistics of RTApp
+bool
+ModbusDevRTU_ReadRTAppStats(InterCoreStats* outStats, bool reset) {
+    unsigned char sendMessage[256];
+    UART_DriverMsg* msg = (UART_DriverMsg*)sendMessage;
+    int msgSize;
+
+    msg->header.requestCode = UART_REQ_STATS;
+    msg->header.messageLen = sizeof(UART_MsgStats);
+    msg->body.stats.reset = reset ? 1 : 0;
+    msgSize = (int)(sizeof(msg->header) + msg->header.messageLen);
+
+    return SendRTApp_SendMessageToRTCoreAndReadMessage((const unsigned char*)msg, msgSize,
+        (unsigned char*)outStats, sizeof(InterCoreStats));
+}
@@ -28,6 +28,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "InterCoreMsg.h"
+#include "UartDriveMsg.h"
+
 typedef struct ModbusCtx ModbusCtx;
 
 // Initialization and cleanup
@@ -37,6 +40,9 @@ extern void ModbusDevRTU_Destroy(ModbusCtx* me);
 // Connect
 extern bool ModbusDevRTU_Connect(ModbusCtx* me);
 
+// Get serial line settings
+extern void ModbusDevRTU_GetSerialConfig(const ModbusCtx* me, int* baud, uint8_t* parity, uint8_t* stop);
+
 // Read status/register
 extern bool ModbusDevRTU_ReadRegister(ModbusCtx* me, int regAddr, int function, unsigned short* dst, int length);
 
@@ -45,4 +51,10 @@ extern bool ModbusDevRTU_WriteRegister(ModbusCtx* me, int regAddr, int funcCode,
 
 // Get RTApp Version
 extern bool ModbusDevRTU_GetRTAppVersion(char* rtAppVersion);
+
+// Set the poll plan of RTApp (no entry stops polling)
+extern bool ModbusDevRTU_SetPollPlan(const UART_PollEntry* entries, int entryNum);
+
+// Read the performance statistics of RTApp (and reset them)
+extern bool ModbusDevRTU_ReadRTAppStats(InterCoreStats* outStats, bool reset);
 #endif  // _MODBUS_DEV_RTU_H_
@@ -24,6 +24,7 @@
 
 #include "ModbusFetchConfig.h"
 
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -46,9 +47,28 @@ const char RegisterCountKey[]           = "registerCount";
 const char FuncCodeKey[]                = "funcCode";
 const char OffsetKey[]                  = "offset";
 const char IntervalKey[]                = "interval";
+const char IntervalMsKey[]              = "intervalMs";
+const char PhaseMsKey[]                 = "phaseMs";
+const char IntervalMaxMsKey[]           = "intervalMaxMs";
 const char MultiplylKey[]               = "multiply";
 const char DeviderKey[]                 = "devider";
 const char AsFloatKey[]                 = "asFloat";
+const char DeadbandKey[]                = "deadband";
+const char DeadbandPercentKey[]         = "deadbandPercent";
+const char MaxSilenceKey[]              = "maxSilence";
+const char AggregateWindowKey[]         = "aggregateWindow";
+const char AggregateStddevKey[]         = "aggregateStddev";
+const char PriorityKey[]                = "priority";
+const char CatchUpKey[]                 = "catchUp";
+
+static const char ModbusPriorityKey[MODBUS_PRIORITY_NUM][11] = {
+    "critical", "normal", "bestEffort"
+};
+const char FetchCatchUpKey[FETCH_CATCHUP_NUM][8] = {
+    "skip", "restart"
+};
+
+#define LATENESS_SUFFIX	"_latenessMs"
 
 #define SET_TELEMETRYCONF_DEVID    0x01
 #define SET_TELEMETRYCONF_REGADDR  0x02
@@ -100,11 +120,6 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
 
     // clean up old configuration and load new content
     if (0 != vector_size(me->mFetchItems)) {
-        ModbusFetchItem*	curs = (ModbusFetchItem*)vector_get_data(me->mFetchItems);
-
-        for (int i = 0, n = vector_size(me->mFetchItems); i < n; ++i) {
-            TelemetryItems_RemoveDictionaryElem(curs->telemetryName);
-        }
         vector_clear(me->mFetchItemPtrs);
         vector_clear(me->mFetchItems);
     }
@@ -138,10 +153,15 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
         pseudo.regCount = 0;
         pseudo.funcCode = 0;
         pseudo.offset = 0;
-        pseudo.intervalSec = 1;
+        pseudo.intervalMs = 1000;
+        pseudo.phaseMs = FETCH_PHASE_AUTO;
+        pseudo.catchUp = FETCH_CATCHUP_SKIP;
+        pseudo.intervalMaxMs = 0;
         pseudo.multiplier = 0;
         pseudo.devider = 0;
         pseudo.asFloat = false;
+        pseudo.priority = MODBUS_PRIORITY_NORMAL;
+        memset(&pseudo.reportCond, 0, sizeof(pseudo.reportCond));
 
         for (unsigned int p = 0, q = configItem->u.object.length; p < q; ++p) {
             if (0 == strcmp(configItem->u.object.values[p].name, DevIDKey)) {
@@ -187,11 +207,35 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
                 }
             } else if (0 == strcmp(configItem->u.object.values[p].name, IntervalKey)) {
                 json_value* item = configItem->u.object.values[p].value;
-                bool ret_parse = json_GetNumericValue(item, &pseudo.intervalSec, 10);
-                if (!ret_parse || pseudo.intervalSec < 1 || pseudo.intervalSec > 86400) {
+                uint32_t value;
+                bool ret_parse = json_GetNumericValue(item, &value, 10);
+                if (!ret_parse || value < 1 || value > 86400) {
+                    ret = false;
+                } else {
+                    pseudo.intervalMs = value * 1000;
+                    setFlag |= SET_TELEMETRYCONF_INTERVAL;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, IntervalMsKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                bool ret_parse = json_GetNumericValue(item, &pseudo.intervalMs, 10);
+                if (!ret_parse || pseudo.intervalMs < FETCH_INTERVAL_MS_MIN
+                    || pseudo.intervalMs > FETCH_INTERVAL_MS_MAX) {
                     ret = false;
                 } else {
-                    setFlag += SET_TELEMETRYCONF_INTERVAL;
+                    setFlag |= SET_TELEMETRYCONF_INTERVAL;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, PhaseMsKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                bool ret_parse = json_GetNumericValue(item, &pseudo.phaseMs, 10);
+                if (!ret_parse || pseudo.phaseMs >= FETCH_INTERVAL_MS_MAX) {
+                    ret = false;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, IntervalMaxMsKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                bool ret_parse = json_GetNumericValue(item, &pseudo.intervalMaxMs, 10);
+                if (!ret_parse || pseudo.intervalMaxMs > FETCH_INTERVAL_MS_MAX) {
+                    pseudo.intervalMaxMs = 0;
+                    ret = false;
                 }
             } else if (0 == strcmp(configItem->u.object.values[p].name, OffsetKey)) {
                 json_value* item = configItem->u.object.values[p].value;
@@ -208,9 +252,76 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
             } else if (0 == strcmp(configItem->u.object.values[p].name, AsFloatKey)) {
                 json_value* item = configItem->u.object.values[p].value;
                 pseudo.asFloat = item->u.boolean;
+            } else if (0 == strcmp(configItem->u.object.values[p].name, DeadbandKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                double value;
+                if (!json_GetDoubleValue(item, &value) || value < 0) {
+                    ret = false;
+                } else {
+                    pseudo.reportCond.deadbandType = DEADBAND_ABSOLUTE;
+                    pseudo.reportCond.deadband = (float)value;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, DeadbandPercentKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                double value;
+                if (!json_GetDoubleValue(item, &value) || value < 0) {
+                    ret = false;
+                } else {
+                    pseudo.reportCond.deadbandType = DEADBAND_PERCENT;
+                    pseudo.reportCond.deadband = (float)value;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, MaxSilenceKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                bool ret_parse = json_GetNumericValue(item, &pseudo.reportCond.maxSilenceSec, 10);
+                if (!ret_parse || pseudo.reportCond.maxSilenceSec > 86400) {
+                    ret = false;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, AggregateWindowKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                bool ret_parse = json_GetNumericValue(item, &pseudo.reportCond.aggregateWindowSec, 10);
+                if (!ret_parse || pseudo.reportCond.aggregateWindowSec > 86400) {
+                    ret = false;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, AggregateStddevKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                if (!json_GetBoolValue(item, &pseudo.reportCond.aggregateStddev)) {
+                    ret = false;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, PriorityKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                int j = 0;
+
+                while (j < MODBUS_PRIORITY_NUM && (item->type != json_string
+                    || 0 != strcmp(item->u.string.ptr, ModbusPriorityKey[j]))) {
+                    j++;
+                }
+                if (j == MODBUS_PRIORITY_NUM) {
+                    ret = false;
+                } else {
+                    pseudo.priority = (ModbusPriority)j;
+                }
+            } else if (0 == strcmp(configItem->u.object.values[p].name, CatchUpKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                int j = 0;
+
+                while (j < FETCH_CATCHUP_NUM && (item->type != json_string
+                    || 0 != strcmp(item->u.string.ptr, FetchCatchUpKey[j]))) {
+                    j++;
+                }
+                if (j == FETCH_CATCHUP_NUM) {
+                    ret = false;
+                } else {
+                    pseudo.catchUp = (FetchCatchUpPolicy)j;
+                }
             }
         }
         
+        // adaptive polling between the interval and the max interval
+        if (pseudo.intervalMaxMs != 0 && pseudo.intervalMaxMs < pseudo.intervalMs) {
+            pseudo.intervalMaxMs = 0;
+            ret = false;
+        }
+
         if (setFlag == SET_TELEMETRYCONF_REQUIRED) {
             vector_add_last(me->mFetchItems, &pseudo);
         } else {
@@ -223,8 +334,16 @@ ModbusFetchConfig_LoadFromJSON(ModbusFetchConfig* me,
         ModbusFetchItem* curs = (ModbusFetchItem*)vector_get_data(me->mFetchItems);
 
         for (int i = 0, n = vector_size(me->mFetchItems); i < n; ++i) {
+            char nameBuf[TELEMETRY_NAME_MAX_LEN + sizeof(LATENESS_SUFFIX)];
+
             vector_add_last(me->mFetchItemPtrs, &curs);
-            TelemetryItems_AddDictionaryElem(curs->telemetryName, curs->asFloat);
+            curs->telemetryKey = TelemetryItems_AddDictionaryElem(
+                curs->telemetryName,
+                curs->asFloat ? TELEMETRY_TYPE_DOUBLE : TELEMETRY_TYPE_INT32);
+            TelemetryItems_SetReportCondition(curs->telemetryKey, &curs->reportCond);
+            snprintf(nameBuf, sizeof(nameBuf), "%s%s", curs->telemetryName, LATENESS_SUFFIX);
+            curs->latenessKey = TelemetryItems_AddDictionaryElem(
+                nameBuf, TELEMETRY_TYPE_UINT32);
             ++curs;
         }
     }
@@ -29,9 +29,22 @@
 
 #include <stdbool.h>
 
+typedef struct TelemetryKey	TelemetryKey;
+
+// priority class of acquisition under bus overload
+typedef enum {
+    MODBUS_PRIORITY_CRITICAL = 0,   // acquired on every period, beyond the time budget
+    MODBUS_PRIORITY_NORMAL,         // acquired within the time budget (possibly late)
+    MODBUS_PRIORITY_BEST_EFFORT,    // skipped when it has passed its deadline
+    MODBUS_PRIORITY_NUM
+} ModbusPriority;
+
 typedef struct ModbusFetchItem {
     char        telemetryName[TELEMETRY_NAME_MAX_LEN + 1];  // telemetry name
-    uint32_t    intervalSec;    // periodic acquisition interval (in seconds)
+    uint32_t    intervalMs;     // periodic acquisition interval (in milliseconds)
+    uint32_t    phaseMs;        // acquisition phase in the interval (FETCH_PHASE_AUTO: automatic)
+    FetchCatchUpPolicy  catchUp;    // policy for the missed periods
+    uint32_t    intervalMaxMs;  // max interval of adaptive polling (0: fixed interval)
     uint32_t    devID;          // slave device ID
     uint32_t    regAddr;        // register address
     uint32_t    regCount;       // read register count
@@ -40,6 +53,10 @@ typedef struct ModbusFetchItem {
     uint32_t    multiplier;     // multiply value
     uint32_t    devider;        // divide value
     bool        asFloat;        // true:float, false: not float 
+    ModbusPriority  priority;   // priority class of acquisition
+    ReportCondition reportCond; // report-by-exception condition
+    const TelemetryKey* telemetryKey;   // key to add telemetry data item
+    const TelemetryKey* latenessKey;    // key to add acquisition lateness
 } ModbusFetchItem;
 
 #endif  // _MODBUS_FETCH_ITEM_H_
@@ -0,0 +1,354 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "ModbusPollPlan.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ModbusFetchItem.h"
+
+// ModbusPollPlan data members
+struct ModbusPollPlan {
+    ModbusPollTransaction*  mTransactions;  // transactions ordered by device
+    int                     mTransactionCount;
+    const ModbusFetchItem** mItems;         // fetch items ordered by transaction
+    int*                    mDueList;       // indexes of due transactions (EDF order)
+    int                     mDueCount;
+    vector                  mTimerTargets;  // vector of ModbusPollTransaction*
+};
+
+//
+// ModbusPollPlan's private procedure/method
+//
+static int
+FetchItem_Comparator(const void* one, const void* two)
+{
+    // order by transaction grouping key, then by register
+    const ModbusFetchItem*	item1 = *(const ModbusFetchItem* const*)one;
+    const ModbusFetchItem*	item2 = *(const ModbusFetchItem* const*)two;
+    const uint32_t	keys1[] = { item1->devID, item1->funcCode, item1->intervalMs,
+        item1->intervalMaxMs, item1->phaseMs, (uint32_t)item1->catchUp,
+        item1->regAddr, item1->regCount };
+    const uint32_t	keys2[] = { item2->devID, item2->funcCode, item2->intervalMs,
+        item2->intervalMaxMs, item2->phaseMs, (uint32_t)item2->catchUp,
+        item2->regAddr, item2->regCount };
+
+    for (size_t i = 0; i < sizeof(keys1) / sizeof(keys1[0]); i++) {
+        if (keys1[i] != keys2[i]) {
+            return (keys1[i] < keys2[i]) ? -1 : 1;
+        }
+    }
+
+    return 0;
+}
+
+static bool
+ModbusPollTransaction_CanAppend(
+    const ModbusPollTransaction* me, const ModbusFetchItem* item)
+{
+    // The item can join if it's acquired at the same time from the same
+    // device and its registers adjoin or overlap. (Gaps aren't bridged,
+    // since reading an unconfigured register may cause an exception.)
+    uint32_t	end = item->regAddr + item->regCount;
+
+    return me->devID == item->devID
+        && me->funcCode == item->funcCode
+        && me->intervalMs == item->intervalMs
+        && me->intervalMaxMs == item->intervalMaxMs
+        && me->phaseMs == item->phaseMs
+        && me->catchUp == item->catchUp
+        && item->regAddr <= me->regAddr + me->regCount
+        && end - me->regAddr <= MODBUS_POLL_MAX_REGS;
+}
+
+static bool
+ModbusPollTransaction_IsPrior(
+    const ModbusPollTransaction* me, const ModbusPollTransaction* other)
+{
+    // order by priority class, deadline, then the plan (i.e. device)
+    if (me->priority != other->priority) {
+        return me->priority < other->priority;
+    }
+    if (me->deadlineMs != other->deadlineMs) {
+        return me->deadlineMs < other->deadlineMs;
+    }
+    return me < other;
+}
+
+static void
+ModbusPollPlan_RemoveDueAt(ModbusPollPlan* me, int pos)
+{
+    me->mTransactions[me->mDueList[pos]].pending = false;
+    me->mDueCount--;
+    memmove(&me->mDueList[pos], &me->mDueList[pos + 1],
+        sizeof(int) * (size_t)(me->mDueCount - pos));
+}
+
+static void
+ModbusPollPlan_Reset(ModbusPollPlan* me)
+{
+    free(me->mTransactions);
+    free(me->mItems);
+    free(me->mDueList);
+    me->mTransactions     = NULL;
+    me->mTransactionCount = 0;
+    me->mItems            = NULL;
+    me->mDueList          = NULL;
+    me->mDueCount         = 0;
+    vector_clear(me->mTimerTargets);
+}
+
+// Initialization and cleanup
+ModbusPollPlan*
+ModbusPollPlan_New(void)
+{
+    ModbusPollPlan*	newObj = (ModbusPollPlan*)malloc(sizeof(ModbusPollPlan));
+
+    if (NULL != newObj) {
+        newObj->mTimerTargets = vector_init(sizeof(ModbusPollTransaction*));
+        if (NULL == newObj->mTimerTargets) {
+            free(newObj);
+            return NULL;
+        }
+        newObj->mTransactions     = NULL;
+        newObj->mTransactionCount = 0;
+        newObj->mItems            = NULL;
+        newObj->mDueList          = NULL;
+        newObj->mDueCount         = 0;
+    }
+
+    return newObj;
+}
+
+void
+ModbusPollPlan_Destroy(ModbusPollPlan* me)
+{
+    ModbusPollPlan_Reset(me);
+    vector_destroy(me->mTimerTargets);
+    free(me);
+}
+
+// Compile the plan from fetch items
+bool
+ModbusPollPlan_Compile(ModbusPollPlan* me, vector fetchItemPtrs)
+{
+    // Sort the fetch items and coalesce the adjoining registers of the
+    // items acquired at the same time into one transaction. All memory is
+    // allocated here, so that acquisition doesn't allocate at all.
+    int	n = vector_size(fetchItemPtrs);
+    ModbusPollTransaction*	curs = NULL;
+
+    ModbusPollPlan_Reset(me);
+    if (0 == n) {
+        return true;
+    }
+
+    me->mItems = (const ModbusFetchItem**)malloc(sizeof(ModbusFetchItem*) * (size_t)n);
+    me->mTransactions =
+        (ModbusPollTransaction*)malloc(sizeof(ModbusPollTransaction) * (size_t)n);
+    me->mDueList = (int*)malloc(sizeof(int) * (size_t)n);
+    if (NULL == me->mItems || NULL == me->mTransactions || NULL == me->mDueList) {
+        ModbusPollPlan_Reset(me);
+        return false;
+    }
+    memcpy(me->mItems, vector_get_data(fetchItemPtrs), sizeof(ModbusFetchItem*) * (size_t)n);
+    qsort(me->mItems, (size_t)n, sizeof(ModbusFetchItem*), FetchItem_Comparator);
+
+    for (int i = 0; i < n; ++i) {
+        const ModbusFetchItem*	item = me->mItems[i];
+
+        if (NULL != curs && ModbusPollTransaction_CanAppend(curs, item)) {
+            uint32_t	end = item->regAddr + item->regCount;
+
+            if (end > curs->regAddr + curs->regCount) {
+                curs->regCount = end - curs->regAddr;
+            }
+            if (item->priority < curs->priority) {
+                curs->priority = item->priority;
+            }
+            curs->itemCount++;
+            continue;
+        }
+        curs = &me->mTransactions[me->mTransactionCount++];
+        strncpy(curs->telemetryName, item->telemetryName, TELEMETRY_NAME_MAX_LEN);
+        curs->telemetryName[TELEMETRY_NAME_MAX_LEN] = '\0';
+        curs->intervalMs = item->intervalMs;
+        curs->phaseMs    = item->phaseMs;
+        curs->catchUp    = item->catchUp;
+        curs->intervalMaxMs = item->intervalMaxMs;
+        curs->devID      = item->devID;
+        curs->funcCode   = item->funcCode;
+        curs->regAddr    = item->regAddr;
+        curs->regCount   = item->regCount;
+        curs->firstItem  = i;
+        curs->itemCount  = 1;
+        curs->priority   = item->priority;
+        curs->pending    = false;
+        curs->releaseMs  = 0;
+        curs->deadlineMs = 0;
+        curs->maxLatenessMs = 0;
+        curs->currentIntervalMs = item->intervalMs;
+        curs->hasLastVal = false;
+    }
+
+    for (int i = 0; i < me->mTransactionCount; ++i) {
+        ModbusPollTransaction*	transaction = &me->mTransactions[i];
+
+        vector_add_last(me->mTimerTargets, &transaction);
+    }
+
+    return true;
+}
+
+// Get the transactions as the targets of FetchTimers
+vector
+ModbusPollPlan_GetTimerTargets(ModbusPollPlan* me)
+{
+    return me->mTimerTargets;
+}
+
+// Manage the due queue, which is ordered by priority class and then by
+// deadline (earliest deadline first)
+void
+ModbusPollPlan_SetDue(ModbusPollPlan* me,
+    const FetchItemBase* transaction, uint64_t releaseMs)
+{
+    // Insert into the due queue keeping the order. A transaction which is
+    // still pending keeps its release, as the oldest sample is outstanding,
+    // except a best-effort one, which is superseded by the new period.
+    int	index = (int)((const ModbusPollTransaction*)transaction - me->mTransactions);
+    ModbusPollTransaction*	target = &me->mTransactions[index];
+    int	pos;
+
+    if (target->pending) {
+        if (MODBUS_PRIORITY_BEST_EFFORT != target->priority) {
+            return;
+        }
+        for (pos = 0; me->mDueList[pos] != index; pos++) {
+            // search
+        }
+        ModbusPollPlan_RemoveDueAt(me, pos);
+    }
+    target->pending    = true;
+    target->releaseMs  = releaseMs;
+    target->deadlineMs = releaseMs + target->currentIntervalMs;
+
+    pos = me->mDueCount;
+    while (0 < pos && ModbusPollTransaction_IsPrior(
+        target, &me->mTransactions[me->mDueList[pos - 1]])) {
+        me->mDueList[pos] = me->mDueList[pos - 1];
+        pos--;
+    }
+    me->mDueList[pos] = index;
+    me->mDueCount++;
+}
+
+int
+ModbusPollPlan_GetDueCount(const ModbusPollPlan* me)
+{
+    return me->mDueCount;
+}
+
+const ModbusPollTransaction*
+ModbusPollPlan_NextDue(ModbusPollPlan* me, uint64_t nowMs)
+{
+    // get the first of the queue, dropping the best-effort transactions
+    // which have passed their deadlines
+    while (0 < me->mDueCount) {
+        const ModbusPollTransaction*	head = &me->mTransactions[me->mDueList[0]];
+
+        if (MODBUS_PRIORITY_BEST_EFFORT != head->priority
+            || nowMs < head->deadlineMs) {
+            return head;
+        }
+        ModbusPollPlan_RemoveDueAt(me, 0);
+    }
+
+    return NULL;
+}
+
+void
+ModbusPollPlan_RemoveDue(ModbusPollPlan* me, uint64_t nowMs)
+{
+    // remove the first of the queue on its acquisition
+    ModbusPollTransaction*	head = &me->mTransactions[me->mDueList[0]];
+    uint64_t	lateness = nowMs - head->releaseMs;
+
+    if (lateness > head->maxLatenessMs) {
+        head->maxLatenessMs = (uint32_t)lateness;
+    }
+    ModbusPollPlan_RemoveDueAt(me, 0);
+}
+
+// Adapt the interval of the transaction to the read registers; back off
+// toward the max interval while they are stable, and return to the
+// configured interval on change (true: the current interval changed)
+bool
+ModbusPollPlan_AdaptInterval(ModbusPollPlan* me,
+    const ModbusPollTransaction* transaction, const unsigned short* readVal)
+{
+    // (the interval is doubled per stable acquisition)
+    ModbusPollTransaction*	self = &me->mTransactions[transaction - me->mTransactions];
+    size_t	size = sizeof(unsigned short) * self->regCount;
+    uint32_t	interval = self->currentIntervalMs;
+
+    if (0 == self->intervalMaxMs) {
+        return false;
+    }
+
+    if (! self->hasLastVal || 0 != memcmp(self->lastVal, readVal, size)) {
+        interval = self->intervalMs;
+    } else if (interval < self->intervalMaxMs) {
+        interval = (interval > self->intervalMaxMs / 2) ?
+            self->intervalMaxMs : interval * 2;
+    }
+    memcpy(self->lastVal, readVal, size);
+    self->hasLastVal = true;
+
+    if (interval == self->currentIntervalMs) {
+        return false;
+    }
+    self->currentIntervalMs = interval;
+
+    return true;
+}
+
+// Get the fetch items of a transaction
+const ModbusFetchItem* const*
+ModbusPollPlan_GetFetchItems(
+    const ModbusPollPlan* me, const ModbusPollTransaction* transaction)
+{
+    return &me->mItems[transaction->firstItem];
+}
+
+// Reset the lateness of all transactions
+void
+ModbusPollPlan_ResetLateness(ModbusPollPlan* me)
+{
+    for (int i = 0; i < me->mTransactionCount; ++i) {
+        me->mTransactions[i].maxLatenessMs = 0;
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _MODBUS_POLL_PLAN_H_
+#define _MODBUS_POLL_PLAN_H_
+
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+#ifndef CONTAINERS_VECTOR_H
+#include "vector.h"
+#endif
+
+#ifndef _MODBUS_FETCH_ITEM_H_
+#include "ModbusFetchItem.h"
+#endif
+
+// max register count of a coalesced bus transaction
+#define MODBUS_POLL_MAX_REGS	32
+
+typedef struct ModbusPollPlan	ModbusPollPlan;
+
+// bus transaction which reads a register range for one or more fetch items
+// (it has same leading members as FetchItemBase, to be given to FetchTimers)
+typedef struct ModbusPollTransaction {
+    char        telemetryName[TELEMETRY_NAME_MAX_LEN + 1];  // first item's name
+    uint32_t    intervalMs;     // periodic acquisition interval (in milliseconds)
+    uint32_t    phaseMs;        // acquisition phase in the interval
+    FetchCatchUpPolicy  catchUp;    // policy for the missed periods
+    uint32_t    intervalMaxMs;  // max interval of adaptive polling (0: fixed interval)
+    uint32_t    devID;          // slave device ID
+    uint32_t    funcCode;       // function code
+    uint32_t    regAddr;        // first register address
+    uint32_t    regCount;       // read register count
+    int         firstItem;      // index of the first fetch item
+    int         itemCount;      // number of fetch items
+    ModbusPriority  priority;   // highest priority class of the items
+    bool        pending;        // in the due queue
+    uint64_t    releaseMs;      // time when it became due (FetchTimers' time)
+    uint64_t    deadlineMs;     // time when the next period begins
+    uint32_t    maxLatenessMs;  // max delay from the release to the acquisition
+    uint32_t    currentIntervalMs;  // current interval of adaptive polling
+    bool        hasLastVal;     // lastVal has been read
+    unsigned short  lastVal[MODBUS_POLL_MAX_REGS];  // last read registers
+} ModbusPollTransaction;
+
+// Initialization and cleanup
+extern ModbusPollPlan*	ModbusPollPlan_New(void);
+extern void	ModbusPollPlan_Destroy(ModbusPollPlan* me);
+
+// Compile the plan from fetch items
+extern bool	ModbusPollPlan_Compile(ModbusPollPlan* me, vector fetchItemPtrs);
+
+// Get the transactions as the targets of FetchTimers
+extern vector	ModbusPollPlan_GetTimerTargets(ModbusPollPlan* me);
+
+// Manage the due queue, which is ordered by priority class and then by
+// deadline (earliest deadline first)
+extern void	ModbusPollPlan_SetDue(ModbusPollPlan* me,
+    const FetchItemBase* transaction, uint64_t releaseMs);
+extern int	ModbusPollPlan_GetDueCount(const ModbusPollPlan* me);
+extern const ModbusPollTransaction*	ModbusPollPlan_NextDue(
+    ModbusPollPlan* me, uint64_t nowMs);
+extern void	ModbusPollPlan_RemoveDue(ModbusPollPlan* me, uint64_t nowMs);
+
+// Adapt the interval of the transaction to the read registers; back off
+// toward the max interval while they are stable, and return to the
+// configured interval on change (true: the current interval changed)
+extern bool	ModbusPollPlan_AdaptInterval(ModbusPollPlan* me,
+    const ModbusPollTransaction* transaction, const unsigned short* readVal);
+
+// Get the fetch items of a transaction
+extern const ModbusFetchItem* const*	ModbusPollPlan_GetFetchItems(
+    const ModbusPollPlan* me, const ModbusPollTransaction* transaction);
+
+// Reset the lateness of all transactions
+extern void	ModbusPollPlan_ResetLateness(ModbusPollPlan* me);
+
+#endif  // _MODBUS_POLL_PLAN_H_
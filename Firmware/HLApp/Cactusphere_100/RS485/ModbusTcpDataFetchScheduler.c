@@ -30,7 +30,6 @@
 #include "ModbusTcpDev.h"
 #include "ModbusTcpFetchItem.h"
 #include "ModbusTcpFetchTargets.h"
-#include "StringBuf.h"
 #include "TelemetryItems.h"
 
 typedef struct ModbusTcpDataFetchScheduler {
@@ -45,7 +44,8 @@ typedef struct ModbusTcpDataFetchScheduler {
 //
 // Callback procedure of FetchTimers
 static void
-ModbusTcpFetchTimerCallback(void* arg, const FetchItemBase* fetchTarget)
+ModbusTcpFetchTimerCallback(void* arg, const FetchItemBase* fetchTarget,
+    uint64_t expiryMs)
 {
     ModbusTcpDataFetchScheduler* scheduler = (ModbusTcpDataFetchScheduler*)arg;
 
@@ -116,7 +116,8 @@ ModbusTcpDataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                         fVal /= item->devider;
                     }
 
-                    StringBuf_AppendByPrintf(me->mStringBuf, "%f", fVal);
+                    TelemetryItems_AddDouble(me->mTelemetryItems,
+                        item->telemetryKey, fVal);
                 }
                 else
                 {
@@ -130,12 +131,9 @@ ModbusTcpDataFetchScheduler_DoSchedule(DataFetchSchedulerBase* me)
                         ulVal /= item->devider;
                     }
 
-                    StringBuf_AppendByPrintf(me->mStringBuf, "%ld", ulVal);
+                    TelemetryItems_AddInt32(me->mTelemetryItems,
+                        item->telemetryKey, (int32_t)ulVal);
                 }
-
-                TelemetryItems_Add(me->mTelemetryItems,
-                    item->telemetryName, StringBuf_GetStr(me->mStringBuf));
-                StringBuf_Clear(me->mStringBuf);
             }
             LibmodbusTcp_Disconnect(modbusdev);
         }
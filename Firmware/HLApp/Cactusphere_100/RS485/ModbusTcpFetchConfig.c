@@ -44,10 +44,19 @@ const char PortKey[]                        = "port";
 const char UnitIdKey[]                      = "unitId";	
 extern const char RegisterAddrKey[];		
 extern const char OffsetKey[];				
-extern const char IntervalKey[];			
+extern const char IntervalKey[];
+extern const char IntervalMsKey[];
+extern const char PhaseMsKey[];			
 extern const char MultiplylKey[];		
 extern const char DeviderKey[];			
 extern const char AsFloatKey[];		 
+extern const char DeadbandKey[];
+extern const char DeadbandPercentKey[];
+extern const char MaxSilenceKey[];
+extern const char AggregateWindowKey[];
+extern const char AggregateStddevKey[];
+extern const char CatchUpKey[];
+extern const char FetchCatchUpKey[FETCH_CATCHUP_NUM][8];
 
 // Initialization and cleanup
 ModbusTcpFetchConfig*
@@ -88,14 +97,10 @@ ModbusTcpFetchConfig_LoadFromJSON(ModbusTcpFetchConfig* me,
     const json_value* json, const char* version)
 {
     json_value* configJson = NULL;
+    bool ret = true;
 
     // clean up old configuration and load new content
     if (0 != vector_size(me->mFetchItems)) {
-        ModbusTcpFetchItem*	curs = (ModbusTcpFetchItem*)vector_get_data(me->mFetchItems);
-
-        for (int i = 0, n = vector_size(me->mFetchItems); i < n; ++i) {
-            TelemetryItems_RemoveDictionaryElem(curs->telemetryName);
-        }
         vector_clear(me->mFetchItemPtrs);
         vector_clear(me->mFetchItems);
     }
@@ -122,10 +127,13 @@ ModbusTcpFetchConfig_LoadFromJSON(ModbusTcpFetchConfig* me,
         pseudo.unitID = 0;
         pseudo.regAddr = 0;
         pseudo.offset = 0;
-        pseudo.intervalSec = 1;
+        pseudo.intervalMs = 1000;
+        pseudo.phaseMs = FETCH_PHASE_AUTO;
+        pseudo.catchUp = FETCH_CATCHUP_SKIP;
         pseudo.multiplier = 0;
         pseudo.devider = 0;
         pseudo.asFloat = false;
+        memset(&pseudo.reportCond, 0, sizeof(pseudo.reportCond));
 
         for (unsigned int p = 0, q = configItem->u.object.length; p < q; ++p) {
             if (0 == strcmp(configItem->u.object.values[p].name, IpAddrKey)) {
@@ -164,11 +172,24 @@ ModbusTcpFetchConfig_LoadFromJSON(ModbusTcpFetchConfig* me,
             else if (0 == strcmp(configItem->u.object.values[p].name, IntervalKey)) { 
                 json_value* item = configItem->u.object.values[p].value;
 
-                pseudo.intervalSec = (unsigned long)item->u.integer;
-                if (pseudo.intervalSec <= 0) {
-                    pseudo.intervalSec = 1;
+                pseudo.intervalMs = (unsigned long)item->u.integer * 1000;
+                if (pseudo.intervalMs <= 0) {
+                    pseudo.intervalMs = 1000;
                 }
             }
+            else if (0 == strcmp(configItem->u.object.values[p].name, IntervalMsKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+
+                pseudo.intervalMs = (unsigned long)item->u.integer;
+                if (pseudo.intervalMs < FETCH_INTERVAL_MS_MIN) {
+                    pseudo.intervalMs = FETCH_INTERVAL_MS_MIN;
+                }
+            }
+            else if (0 == strcmp(configItem->u.object.values[p].name, PhaseMsKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+
+                pseudo.phaseMs = (unsigned long)item->u.integer;
+            }
             else if (0 == strcmp(configItem->u.object.values[p].name, OffsetKey)) { 
                 json_value* item = configItem->u.object.values[p].value;
 
@@ -189,6 +210,65 @@ ModbusTcpFetchConfig_LoadFromJSON(ModbusTcpFetchConfig* me,
 
                 pseudo.asFloat = item->u.boolean;
             }
+            else if (0 == strcmp(configItem->u.object.values[p].name, DeadbandKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                double value;
+
+                if (!json_GetDoubleValue(item, &value) || value < 0) {
+                    ret = false;
+                } else {
+                    pseudo.reportCond.deadbandType = DEADBAND_ABSOLUTE;
+                    pseudo.reportCond.deadband = (float)value;
+                }
+            }
+            else if (0 == strcmp(configItem->u.object.values[p].name, DeadbandPercentKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                double value;
+
+                if (!json_GetDoubleValue(item, &value) || value < 0) {
+                    ret = false;
+                } else {
+                    pseudo.reportCond.deadbandType = DEADBAND_PERCENT;
+                    pseudo.reportCond.deadband = (float)value;
+                }
+            }
+            else if (0 == strcmp(configItem->u.object.values[p].name, MaxSilenceKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                bool ret_parse = json_GetNumericValue(item, &pseudo.reportCond.maxSilenceSec, 10);
+
+                if (!ret_parse || pseudo.reportCond.maxSilenceSec > 86400) {
+                    ret = false;
+                }
+            }
+            else if (0 == strcmp(configItem->u.object.values[p].name, AggregateWindowKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                bool ret_parse = json_GetNumericValue(item, &pseudo.reportCond.aggregateWindowSec, 10);
+
+                if (!ret_parse || pseudo.reportCond.aggregateWindowSec > 86400) {
+                    ret = false;
+                }
+            }
+            else if (0 == strcmp(configItem->u.object.values[p].name, AggregateStddevKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+
+                if (!json_GetBoolValue(item, &pseudo.reportCond.aggregateStddev)) {
+                    ret = false;
+                }
+            }
+            else if (0 == strcmp(configItem->u.object.values[p].name, CatchUpKey)) {
+                json_value* item = configItem->u.object.values[p].value;
+                int j = 0;
+
+                while (j < FETCH_CATCHUP_NUM && (item->type != json_string
+                    || 0 != strcmp(item->u.string.ptr, FetchCatchUpKey[j]))) {
+                    j++;
+                }
+                if (j == FETCH_CATCHUP_NUM) {
+                    ret = false;
+                } else {
+                    pseudo.catchUp = (FetchCatchUpPolicy)j;
+                }
+            }
 
         }
         vector_add_last(me->mFetchItems, &pseudo);
@@ -199,11 +279,14 @@ ModbusTcpFetchConfig_LoadFromJSON(ModbusTcpFetchConfig* me,
 
         for (int i = 0, n = vector_size(me->mFetchItems); i < n; ++i) {
             vector_add_last(me->mFetchItemPtrs, &curs);
-            TelemetryItems_AddDictionaryElem(curs->telemetryName, curs->asFloat);
+            curs->telemetryKey = TelemetryItems_AddDictionaryElem(
+                curs->telemetryName,
+                curs->asFloat ? TELEMETRY_TYPE_DOUBLE : TELEMETRY_TYPE_INT32);
+            TelemetryItems_SetReportCondition(curs->telemetryKey, &curs->reportCond);
             ++curs;
         }
 
-        return true;
+        return ret;
     }
     return false;
 }
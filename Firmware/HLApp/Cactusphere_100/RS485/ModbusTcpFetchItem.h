@@ -29,9 +29,13 @@
 
 #include <stdbool.h>
 
+typedef struct TelemetryKey	TelemetryKey;
+
 typedef struct ModbusTcpFetchItem {
     char	    telemetryName[TELEMETRY_NAME_MAX_LEN + 1];  // telemetry name
-    uint32_t	intervalSec;    // periodic acquisition interval (in seconds)
+    uint32_t	intervalMs;     // periodic acquisition interval (in milliseconds)
+    uint32_t	phaseMs;        // acquisition phase in the interval (FETCH_PHASE_AUTO: automatic)
+    FetchCatchUpPolicy	catchUp;    // policy for the missed periods
     char		ipAddr[16];	    // ip address
     uint32_t	port;			// port num
     uint32_t	unitID;         // unit id
@@ -40,6 +44,8 @@ typedef struct ModbusTcpFetchItem {
     uint32_t	multiplier;     // multiply value
     uint32_t	devider;        // divide value
     bool	    asFloat;        // true:float, false: not float 
+    ReportCondition reportCond; // report-by-exception condition
+    const TelemetryKey* telemetryKey;   // key to add telemetry data item
 } ModbusTcpFetchItem;
 
 #endif  // _MODBUS_FETCH_ITEM_H_
@@ -104,7 +104,7 @@ ModbusTcpFetchTargets_New(void)
     if (NULL != newObj) {
         newObj->mTargetsDictByDevID = dictionary_init(
             MODBUS_TCP_ID_SIZE, sizeof(ModbusTcpFetchItemsPerDev*),
-            ID_Comparator);
+            ID_Comparator, dictionary_hash_chars);
         if (NULL == newObj->mTargetsDictByDevID) {
             free(newObj);
             return NULL;
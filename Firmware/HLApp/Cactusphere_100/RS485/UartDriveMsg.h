@@ -31,11 +31,15 @@
 
 // constants
 #define MAX_UART_WRITE_LEN	256
+#define UART_POLL_PLAN_MAX	20  // max entries of the poll plan
+#define UART_POLL_REGS_MAX	32  // max registers read by an entry
 
 // request code
 enum {
     UART_REQ_WRITE_AND_READ = 1,  // send request and receive response aganist opposing device
     UART_REQ_SET_PARAMS     = 2,  // setting UART parameters
+    UART_REQ_SET_POLL_PLAN  = 3,  // setting the plan of autonomous polling
+    UART_REQ_STATS          = 4,  // read the performance statistics (InterCoreStats)
     UART_REQ_VERSION        = 255,// RTApp Version
 };
 
@@ -68,6 +72,33 @@ typedef struct UART_MsgSetParams {
 // sizeof(UART_MsgSetParams) == messageLen
 //
 } UART_MsgSetParams;
+    // UART_REQ_SET_POLL_PLAN
+typedef struct UART_PollEntry {
+    uint32_t	periodMs;   // polling interval
+    uint32_t	phaseMs;    // delay of the first polling
+    uint32_t	baudRate;   // serial line settings of the device
+    uint16_t	regAddr;    // first register address
+    uint16_t	regCount;   // number of registers (<= UART_POLL_REGS_MAX)
+    uint8_t 	devId;      // slave ID
+    uint8_t 	funcCode;   // read holding/input registers (0x03 or 0x04)
+    uint8_t 	parity;
+    uint8_t 	stop;
+} UART_PollEntry;
+typedef struct UART_MsgPollPlan {
+    uint32_t	entryNum;
+    UART_PollEntry	entries[UART_POLL_PLAN_MAX];
+//
+// (sizeof(entryNum) + sizeof(UART_PollEntry) * entryNum) == messageLen
+// entryNum must (<= UART_POLL_PLAN_MAX), 0 stops polling
+//
+} UART_MsgPollPlan;
+    // UART_REQ_STATS
+typedef struct UART_MsgStats {
+    uint32_t	reset;  // reset the statistics after read (0: keep)
+//
+// sizeof(UART_MsgStats) == messageLen
+//
+} UART_MsgStats;
 
 // union of messages
 typedef struct UART_DriverMsg {
@@ -75,6 +106,8 @@ typedef struct UART_DriverMsg {
     union {
         UART_MsgWriteAndRead    writeAndReadReq;
         UART_MsgSetParams       setParams;
+        UART_MsgPollPlan        pollPlan;
+        UART_MsgStats           stats;
     } body;
 } UART_DriverMsg;
 
@@ -22,28 +22,33 @@
  * THE SOFTWARE.
  */
 
-#ifndef _MODBUS_FETCH_TARGETS_H_
-#define _MODBUS_FETCH_TARGETS_H_
+#ifndef _DICTIONARY_H_
+#define _DICTIONARY_H_
 
 #ifndef CONTAINERS_VECTOR_H
 #include "vector.h"
 #endif
 
-typedef struct ModbusFetchTargets	ModbusFetchTargets;
-typedef struct ModbusFetchItem	ModbusFetchItem;
+typedef struct internal_dictionary	*dictionary;
 
-// Initialization and cleanup
-extern ModbusFetchTargets*	ModbusFetchTargets_New(void);
-extern void	ModbusFetchTargets_Destroy(ModbusFetchTargets* me);
+/* Starting */
+dictionary dictionary_init(size_t key_size,
+    size_t value_size,
+    int(*comparator)(const void *const one, const void *const two));
 
-// Get current acquisition targets
-extern vector	ModbusFetchTargets_GetDevIDs(ModbusFetchTargets* me);
-extern vector	ModbusFetchTargets_GetFetchItems(
-    ModbusFetchTargets* me, unsigned long devID);
+/* Capacity */
+int dictionary_size(dictionary me);
+int dictionary_is_empty(dictionary me);
 
-// Manage acquisition targets
-extern void	ModbusFetchTargets_Add(
-    ModbusFetchTargets* me, const ModbusFetchItem* target);
-extern void	ModbusFetchTargets_Clear(ModbusFetchTargets* me);
+/* Accessing */
+int dictionary_put(dictionary me, void *key, void *value);
+int dictionary_get(void *value, dictionary me, void *key);
+int dictionary_contains(dictionary me, void *key);
+int dictionary_remove(dictionary me, void *key);
+vector	dictionary_get_keys(dictionary me);
 
-#endif  // _MODBUS_FETCH_TARGETS_H_
+/* Ending */
+void dictionary_clear(dictionary me);
+dictionary dictionary_destroy(dictionary me);
+
+#endif  // _DICTIONARY_H_
@@ -0,0 +1,160 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Microbenchmark of dictionary with the access patterns of the HLApp:
+//  - telemetry item dictionary (char* key), looked up per item per tick
+//  - Modbus/TCP fetch targets (char[] key), rebuilt per tick
+// Built against both of common/ and baseline/ (DICTIONARY_BASELINE).
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "dictionary.h"
+
+#define ITEM_NUM	64      // number of telemetry items
+#define TARGET_NUM	16      // number of Modbus/TCP devices
+#define ID_SIZE	21      // same as MODBUS_TCP_ID_SIZE
+#define REPEAT	100000
+
+static char	sItemNames[ITEM_NUM][32];
+static char*	sItemKeys[ITEM_NUM];
+static char	sTargetIds[TARGET_NUM][ID_SIZE];
+
+static int
+ItemComparator(const void* const one, const void* const two)
+{
+    return strcmp(*((char**)one), *((char**)two));
+}
+
+static int
+IdComparator(const void* const one, const void* const two)
+{
+    return strcmp(one, two);
+}
+
+#ifdef DICTIONARY_BASELINE
+#define DICT_INIT(keySize, valueSize, comparator, hash) \
+    dictionary_init(keySize, valueSize, comparator)
+#else
+#define DICT_INIT(keySize, valueSize, comparator, hash) \
+    dictionary_init(keySize, valueSize, comparator, hash)
+#endif
+
+static double
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void
+Report(const char* name, double start, long ops)
+{
+    printf("%-28s %8.1f ns/op\n", name, (NowNs() - start) / (double)ops);
+}
+
+int
+main(void)
+{
+    dictionary	items;
+    dictionary	targets;
+    double	start;
+    long	sum = 0;
+
+    for (int i = 0; i < ITEM_NUM; i++) {
+        snprintf(sItemNames[i], sizeof(sItemNames[i]), "Temperature_%d", i);
+        sItemKeys[i] = sItemNames[i];
+    }
+    for (int i = 0; i < TARGET_NUM; i++) {
+        snprintf(sTargetIds[i], ID_SIZE, "192.168.10.%d:502", i + 1);
+    }
+    items = DICT_INIT(sizeof(char*), sizeof(int),
+        ItemComparator, dictionary_hash_string);
+    targets = DICT_INIT(ID_SIZE, sizeof(void*),
+        IdComparator, dictionary_hash_chars);
+    if (NULL == items || NULL == targets) {
+        fprintf(stderr, "dictionary_init failed\n");
+        return 1;
+    }
+
+    // put (from empty)
+    start = NowNs();
+    for (int r = 0; r < REPEAT; r++) {
+        dictionary_clear(items);
+        for (int i = 0; i < ITEM_NUM; i++) {
+            dictionary_put(items, &sItemKeys[i], &i);
+        }
+    }
+    Report("item clear+put", start, (long)REPEAT * ITEM_NUM);
+
+    // get (hit)
+    start = NowNs();
+    for (int r = 0; r < REPEAT; r++) {
+        for (int i = 0; i < ITEM_NUM; i++) {
+            int	value;
+
+            dictionary_get(&value, items, &sItemKeys[i]);
+            sum += value;
+        }
+    }
+    Report("item get", start, (long)REPEAT * ITEM_NUM);
+
+    // remove all, then put again
+    start = NowNs();
+    for (int r = 0; r < REPEAT / 10; r++) {
+        for (int i = 0; i < ITEM_NUM; i++) {
+            dictionary_remove(items, &sItemKeys[i]);
+        }
+        for (int i = 0; i < ITEM_NUM; i++) {
+            dictionary_put(items, &sItemKeys[i], &i);
+        }
+    }
+    Report("item remove+put", start, (long)REPEAT / 10 * ITEM_NUM);
+
+    // rebuild of the fetch targets per tick
+    start = NowNs();
+    for (int r = 0; r < REPEAT; r++) {
+        dictionary_clear(targets);
+        for (int i = 0; i < TARGET_NUM; i++) {
+            void*	perDev = NULL;
+
+            if (! dictionary_get(&perDev, targets, sTargetIds[i])) {
+                perDev = sTargetIds[i];
+                dictionary_put(targets, sTargetIds[i], &perDev);
+            }
+            sum += (NULL != perDev);
+        }
+    }
+    Report("target clear+get+put", start, (long)REPEAT * TARGET_NUM);
+
+    printf("(checksum %ld)\n", sum);
+    dictionary_destroy(items);
+    dictionary_destroy(targets);
+
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Randomized check of dictionary: put/get/remove/clear are applied to both
+// of a dictionary and a reference table, and the results are compared.
+// Usage: dictionary_check [seed [iterations]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dictionary.h"
+
+#define KEY_NUM	300     // number of distinct keys
+#define KEY_SIZE	21      // same as MODBUS_TCP_ID_SIZE
+#define NO_VALUE	(-1)
+
+static char	sKeys[KEY_NUM][KEY_SIZE];
+static int	sRef[KEY_NUM];  // reference value of each key (NO_VALUE: absent)
+
+static int
+KeyComparator(const void* const one, const void* const two)
+{
+    return strcmp(one, two);
+}
+
+// Check the size and the key list of the dictionary against the reference
+static int
+CheckContents(dictionary dict)
+{
+    vector	keys = dictionary_get_keys(dict);
+    int	refSize = 0;
+
+    for (int i = 0; i < KEY_NUM; i++) {
+        if (NO_VALUE != sRef[i]) {
+            refSize++;
+        }
+    }
+    if (refSize != dictionary_size(dict) || refSize != vector_size(keys)) {
+        fprintf(stderr, "size mismatch: %d (dictionary %d, keys %d)\n",
+            refSize, dictionary_size(dict), vector_size(keys));
+        return -1;
+    }
+    for (int i = 0, n = vector_size(keys); i < n; i++) {
+        char	key[KEY_SIZE];
+        int	index;
+
+        vector_get_at(key, keys, i);
+        index = atoi(strrchr(key, '.') + 1);
+        if (NO_VALUE == sRef[index]) {
+            fprintf(stderr, "unexpected key: %s\n", key);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int
+main(int argc, char* argv[])
+{
+    unsigned int	seed = (1 < argc) ? (unsigned int)strtoul(argv[1], NULL, 0) : 1;
+    long	iteration = (2 < argc) ? strtol(argv[2], NULL, 0) : 2000000;
+    dictionary	dict;
+
+    for (int i = 0; i < KEY_NUM; i++) {
+        snprintf(sKeys[i], KEY_SIZE, "10.0.%d.%d", i % 7, i);
+        sRef[i] = NO_VALUE;
+    }
+    dict = dictionary_init(KEY_SIZE, sizeof(int),
+        KeyComparator, dictionary_hash_chars);
+    if (NULL == dict) {
+        fprintf(stderr, "dictionary_init failed\n");
+        return 1;
+    }
+
+    srand(seed);
+    for (long it = 0; it < iteration; it++) {
+        int	k = rand() % KEY_NUM;
+        int	value;
+
+        switch (rand() % 8) {
+        case 0:  // remove
+            if (dictionary_remove(dict, sKeys[k]) != (NO_VALUE != sRef[k])) {
+                fprintf(stderr, "#%ld: remove(%s) mismatch\n", it, sKeys[k]);
+                goto err;
+            }
+            sRef[k] = NO_VALUE;
+            break;
+        case 1:  // put
+        case 2:
+            value = rand();
+            if (0 != dictionary_put(dict, sKeys[k], &value)) {
+                fprintf(stderr, "#%ld: put(%s) failed\n", it, sKeys[k]);
+                goto err;
+            }
+            sRef[k] = value;
+            break;
+        case 3:  // clear (rarely)
+            if (0 == rand() % 10000) {
+                dictionary_clear(dict);
+                for (int i = 0; i < KEY_NUM; i++) {
+                    sRef[i] = NO_VALUE;
+                }
+                break;
+            }
+            // fall through
+        default:  // get
+            value = NO_VALUE;
+            if (dictionary_get(&value, dict, sKeys[k]) != (NO_VALUE != sRef[k])
+                || value != sRef[k]) {
+                fprintf(stderr, "#%ld: get(%s) mismatch\n", it, sKeys[k]);
+                goto err;
+            }
+            break;
+        }
+        if (0 == it % 100000 && 0 != CheckContents(dict)) {
+            goto err;
+        }
+    }
+    if (0 != CheckContents(dict)) {
+        goto err;
+    }
+    dictionary_destroy(dict);
+    printf("dictionary_check: OK (seed %u, %ld iterations)\n", seed, iteration);
+
+    return 0;
+
+err:
+    dictionary_destroy(dict);
+    printf("dictionary_check: NG (seed %u)\n", seed);
+
+    return 1;
+}
@@ -0,0 +1,218 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+// Benchmark of building a telemetry payload:
+//  - baseline: StringBuf_AppendByPrintf() per item into a vector-backed
+//    StringBuf (TelemetryItems_ToJson() before the direct-write encoder)
+//  - current:  TelemetryItems_ToJson() into a reusable buffer
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "TelemetryItems.h"
+#include "baseline/StringBuf.h"
+
+#define ITEM_NUM	10
+#define REPEAT	200000
+
+typedef struct BenchItem {
+    const char*	name;
+    TelemetryValueType	type;
+    const TelemetryKey*	key;
+} BenchItem;
+
+static BenchItem	sItems[ITEM_NUM] = {
+    { "Temperature",    TELEMETRY_TYPE_FLOAT,  NULL },
+    { "Humidity",       TELEMETRY_TYPE_FLOAT,  NULL },
+    { "Pressure",       TELEMETRY_TYPE_DOUBLE, NULL },
+    { "FlowRate",       TELEMETRY_TYPE_DOUBLE, NULL },
+    { "Counter1",       TELEMETRY_TYPE_UINT32, NULL },
+    { "Counter2",       TELEMETRY_TYPE_UINT32, NULL },
+    { "Offset",         TELEMETRY_TYPE_INT32,  NULL },
+    { "Power",          TELEMETRY_TYPE_INT32,  NULL },
+    { "Alarm",          TELEMETRY_TYPE_BOOL,   NULL },
+    { "Running",        TELEMETRY_TYPE_BOOL,   NULL },
+};
+
+static double
+NowNs(void)
+{
+    struct timespec	ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Sample value of the item in the n-th payload
+static double
+SampleValue(int n, int i)
+{
+    return (double)((n * 7 + i * 13) % 1000) / 8.0 - 20.0;
+}
+
+// The serialization before the direct-write encoder
+static const char*
+Baseline_ToJson(StringBuf* sb, int n)
+{
+    StringBuf_Clear(sb);
+    StringBuf_AppendChar(sb, '{');
+    for (int i = 0; i < ITEM_NUM; i++) {
+        const BenchItem*	item = &sItems[i];
+        double	value = SampleValue(n, i);
+
+        switch (item->type) {
+        case TELEMETRY_TYPE_INT32:
+            StringBuf_AppendByPrintf(sb, "\"%s\":%ld",
+                item->name, (long)value);
+            break;
+        case TELEMETRY_TYPE_FLOAT:
+            StringBuf_AppendByPrintf(sb, "\"%s\":%f",
+                item->name, (float)value);
+            break;
+        case TELEMETRY_TYPE_DOUBLE:
+            StringBuf_AppendByPrintf(sb, "\"%s\":%f",
+                item->name, value);
+            break;
+        case TELEMETRY_TYPE_BOOL:
+            StringBuf_AppendByPrintf(sb, "\"%s\":%s",
+                item->name, (0 < value) ? "true" : "false");
+            break;
+        default:
+            StringBuf_AppendByPrintf(sb, "\"%s\":%lu",
+                item->name, (unsigned long)(value + 20.0) * 1000);
+            break;
+        }
+        if (ITEM_NUM - 1 > i) {
+            StringBuf_AppendChar(sb, ',');
+        }
+    }
+    StringBuf_AppendChar(sb, '}');
+
+    return StringBuf_GetStr(sb);
+}
+
+// The current serialization
+static const char*
+Current_ToJson(TelemetryItems* items, char** buf, size_t* bufSize, int n)
+{
+    size_t	sizeMax;
+
+    TelemetryItems_Clear(items);
+    for (int i = 0; i < ITEM_NUM; i++) {
+        const BenchItem*	item = &sItems[i];
+        double	value = SampleValue(n, i);
+
+        switch (item->type) {
+        case TELEMETRY_TYPE_INT32:
+            TelemetryItems_AddInt32(items, item->key, (int32_t)value);
+            break;
+        case TELEMETRY_TYPE_FLOAT:
+            TelemetryItems_AddFloat(items, item->key, (float)value);
+            break;
+        case TELEMETRY_TYPE_DOUBLE:
+            TelemetryItems_AddDouble(items, item->key, value);
+            break;
+        case TELEMETRY_TYPE_BOOL:
+            TelemetryItems_AddBool(items, item->key, (0 < value));
+            break;
+        default:
+            TelemetryItems_AddUInt32(items, item->key,
+                (uint32_t)(value + 20.0) * 1000);
+            break;
+        }
+    }
+
+    // grow the buffer only when the payload may exceed it (as LibCloud does)
+    sizeMax = TelemetryItems_GetJsonSizeMax(items);
+    if (*bufSize < sizeMax) {
+        char*	newBuf = realloc(*buf, sizeMax);
+
+        if (NULL == newBuf) {
+            return NULL;
+        }
+        *buf     = newBuf;
+        *bufSize = sizeMax;
+    }
+    if (0 > TelemetryItems_ToJson(items, *buf, *bufSize)) {
+        return NULL;
+    }
+
+    return *buf;
+}
+
+int
+main(void)
+{
+    StringBuf*	sb = StringBuf_New();
+    TelemetryItems*	items = TelemetryItems_New();
+    char*	buf = NULL;
+    size_t	bufSize = 0;
+    size_t	total = 0;
+    double	start, baselineNs, currentNs;
+
+    if (NULL == sb || NULL == items) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+    TelemetryItems_InitDictionary();
+    for (int i = 0; i < ITEM_NUM; i++) {
+        sItems[i].key = TelemetryItems_AddDictionaryElem(
+            sItems[i].name, sItems[i].type);
+    }
+    printf("baseline: %s\n", Baseline_ToJson(sb, 1));
+    printf("current:  %s\n", Current_ToJson(items, &buf, &bufSize, 1));
+
+    start = NowNs();
+    for (int n = 0; n < REPEAT; n++) {
+        total += strlen(Baseline_ToJson(sb, n));
+    }
+    baselineNs = (NowNs() - start) / REPEAT;
+
+    start = NowNs();
+    for (int n = 0; n < REPEAT; n++) {
+        const char*	json = Current_ToJson(items, &buf, &bufSize, n);
+
+        if (NULL == json) {
+            fprintf(stderr, "TelemetryItems_ToJson failed\n");
+            return 1;
+        }
+        total += strlen(json);
+    }
+    currentNs = (NowNs() - start) / REPEAT;
+
+    printf("baseline %8.1f ns/payload\n", baselineNs);
+    printf("current  %8.1f ns/payload (x%.1f)\n",
+        currentNs, baselineNs / currentNs);
+    printf("(%d items per payload, checksum %zu)\n", ITEM_NUM, total);
+
+    free(buf);
+    TelemetryItems_Destroy(items);
+    TelemetryItems_CleanupDictionary();
+    StringBuf_Destroy(sb);
+
+    return 0;
+}
@@ -24,16 +24,120 @@
 
 #include "DataFetchScheduler.h"
 
+#include <errno.h>
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 
+#include <applibs/log.h>
+
+#include "InterCoreMsg.h"
 #include "LibCloud.h"
-#include "StringBuf.h"
+#include "SpscRing.h"
 #include "TelemetryItems.h"
 
 extern bool	IsAuthenticationDone(void);
 
+// number of the batches in flight from the field bus thread
+#define FETCH_BATCH_NUM	16
+
+// telemetry data items acquired by a scheduler at once
+typedef struct FetchBatch {
+    DataFetchScheduler*	scheduler;
+    TelemetryItems*	items;
+} FetchBatch;
+
 static DataFetchSchedulerBase*	sPrimaryScheduler = NULL;
 
+// hand-off of the batches from the field bus thread to the main thread
+static int	sSchedulerCount = 0;
+static FetchBatch	sBatches[FETCH_BATCH_NUM];
+static SpscRing*	sFreeBatches = NULL;      // main thread -> field bus thread
+static SpscRing*	sAcquiredBatches = NULL;  // field bus thread -> main thread
+static int	sBatchEventFd = -1;             // notifies the acquired batches
+static EventLoop*	sMainLoop = NULL;
+static EventRegistration*	sBatchEventReg = NULL;
+
+// telemetry name prefix (per IO_Feature) and suffix of statistics
+static const char* const	sStatsPrefixes[] = {
+    "ModbusRTU", "ModbusTCP", "DI"
+};
+static const char* const	sStatsSuffixes[FETCH_STATS_NUM] = {
+    "_fetchCount", "_fetchOverrun", "_fetchMissed", "_fetchMaxLatenessMs"
+};
+static const char* const	sRTStatsSuffixes[RTAPP_STATS_NUM] = {
+    "_rtRequests", "_rtRejected", "_rtSamplesDropped",
+    "_rtRequestMaxUs", "_rtRequestP99Us",
+    "_rtEvents", "_rtTimeouts", "_rtTxBytes", "_rtRxBytes",
+    "_rtEventMaxUs", "_rtEventP50Us", "_rtEventP99Us"
+};
+
+static uint32_t
+DataFetchScheduler_Percentile(const InterCoreHist* hist, uint32_t percent)
+{
+    // upper bound of the histogram bin which includes the percentile
+    // (the max is exact)
+    uint32_t	rank = (uint32_t)(((uint64_t)hist->count * percent + 99) / 100);
+    uint32_t	sum  = 0;
+
+    for (int i = 0; i < INTERCORE_HIST_BINS - 1; i++) {
+        sum += hist->bins[i];
+        if (0 < sum && sum >= rank) {
+            uint32_t	upper = (UINT32_C(2) << i) - 1;
+
+            return (upper < hist->maxUs) ? upper : hist->maxUs;
+        }
+    }
+
+    return hist->maxUs;
+}
+
+static void
+DataFetchScheduler_AddRTAppStats(DataFetchScheduler* me)
+{
+    // add the performance statistics of RTApp (reset per period),
+    // to find the bottlenecks of the field bus
+    InterCoreStats	stats;
+    uint32_t	values[RTAPP_STATS_NUM];
+
+    if (NULL == me->mRTStatsKeys[0] || ! me->ReadRTAppStats(me, &stats)) {
+        return;
+    }
+    values[0]  = stats.requests;
+    values[1]  = stats.rejected;
+    values[2]  = stats.samplesDropped;
+    values[3]  = stats.requestUs.maxUs;
+    values[4]  = DataFetchScheduler_Percentile(&stats.requestUs, 99);
+    values[5]  = stats.events;
+    values[6]  = stats.timeouts;
+    values[7]  = stats.txBytes;
+    values[8]  = stats.rxBytes;
+    values[9]  = stats.eventUs.maxUs;
+    values[10] = DataFetchScheduler_Percentile(&stats.eventUs, 50);
+    values[11] = DataFetchScheduler_Percentile(&stats.eventUs, 99);
+    for (int i = 0; i < RTAPP_STATS_NUM; i++) {
+        TelemetryItems_AddUInt32(me->mTelemetryItems, me->mRTStatsKeys[i], values[i]);
+    }
+}
+
+static void
+DataFetchScheduler_AddStats(DataFetchScheduler* me)
+{
+    // add the acquisition timing statistics as telemetry per period,
+    // to tell the achieved acquisition rate
+    FetchTimerStats	stats;
+
+    if (! FetchTimers_TakeStats(me->mFetchTimers, FETCH_STATS_PERIOD_MS, &stats)) {
+        return;
+    }
+    TelemetryItems_AddUInt32(me->mTelemetryItems, me->mStatsKeys[0], stats.fetchCount);
+    TelemetryItems_AddUInt32(me->mTelemetryItems, me->mStatsKeys[1], stats.overrunCount);
+    TelemetryItems_AddUInt32(me->mTelemetryItems, me->mStatsKeys[2], stats.missedCount);
+    TelemetryItems_AddUInt32(me->mTelemetryItems, me->mStatsKeys[3], stats.maxLatenessMs);
+    DataFetchScheduler_AddRTAppStats(me);
+}
+
 // Default implementation of virtual method
 static void
 DataFetchSchedulerBase_DoDestroy(DataFetchSchedulerBase* me)
@@ -48,6 +152,14 @@ DataFetchSchedulerBase_DoInit(
     // do nothing
 }
 
+static vector
+DataFetchSchedulerBase_GetTimerTargets(
+    DataFetchSchedulerBase* me, vector fetchItemPtrs)
+{
+    // a timer per fetch item
+    return fetchItemPtrs;
+}
+
 static void
 DataFetchSchedulerBase_ClearFetchTargets(DataFetchSchedulerBase* me)
 {
@@ -60,55 +172,31 @@ DataFetchSchedulerBase_DoSchedule(DataFetchSchedulerBase* me)
     // do nothing
 }
 
-// Initialization and cleanup
-void
-DataFetchScheduler_Init(DataFetchScheduler* me, vector fetchItemPtrs)
+static bool
+DataFetchSchedulerBase_ReadRTAppStats(
+    DataFetchSchedulerBase* me, InterCoreStats* outStats)
 {
-    // initialize the generalized/base class's member and  
-    // do for specialized/derived class
-    FetchTimers_Init(me->mFetchTimers, fetchItemPtrs);
-    TelemetryItems_Clear(me->mTelemetryItems);
-    StringBuf_Clear(me->mStringBuf);
-
-    me->DoInit((DataFetchSchedulerBase*)me, fetchItemPtrs);
-
-    // set first instance as primary
-    if (NULL == sPrimaryScheduler) {
-        sPrimaryScheduler = me;
-    }
-}
-
-void
-DataFetchScheduler_Destroy(DataFetchScheduler* me)
-{
-    // cleanup member of specialized class and generalized class
-    me->DoDestroy(me);
-
-    StringBuf_Destroy(me->mStringBuf);
-    TelemetryItems_Destroy(me->mTelemetryItems);
-    FetchTimers_Destroy(me->mFetchTimers);
-
-    free(me);
+    // no RTApp
+    return false;
 }
 
-// Periodic operation (per 1[sec])
-void
-DataFetchScheduler_Schedule(DataFetchScheduler* me)
+static void
+DataFetchScheduler_Deliver(DataFetchScheduler* me, TelemetryItems* items)
 {
-    // Do data acquisition by specialized class and send it as telemetry.
-    // If nettwork is down, store the acquired data to cache and send it after recovery. 
-    const char* telemtryStr;
+    // Send the acquired data as telemetry. If nettwork is down, store 
+    // the data to cache and send it after recovery. 
+    // (runs on the main thread)
 
-    me->ClearFetchTargets(me);
-    TelemetryItems_Clear(me->mTelemetryItems);
-    StringBuf_Clear(me->mStringBuf);
+    // fold the samples into windowed aggregates, then
+    // drop the values which haven't changed enough to be reported
+    {
+        uint32_t	now = IoT_CentralLib_GetTmeStamp();
 
-    FetchTimers_UpdateTimers(me->mFetchTimers);
-
-    me->DoSchedule(me);
+        TelemetryItems_Aggregate(items, now);
+        TelemetryItems_RemoveUnchanged(items, now);
+    }
 
-    telemtryStr = TelemetryItems_ToJson(me->mTelemetryItems);
-    if (0 != strcmp(telemtryStr, "{}")) {
+    if (0 != TelemetryItems_Count(items)) {
         bool	isNetworkAlive = IoT_CentralLib_CheckConnection();
         uint32_t	timeStamp = IoT_CentralLib_GetTmeStamp();
 
@@ -126,8 +214,11 @@ DataFetchScheduler_Schedule(DataFetchScheduler* me)
                     goto do_cache;   // still outstanding cache, so append new data
                 }
             }
+            if (IoT_CentralLib_IsSendQueueFull()) {
+                goto do_cache;   // too many messages in flight, so hold new data
+            }
 
-            if (! IoT_CentralLib_SendTelemetry(telemtryStr, &timeStamp)) {
+            if (! IoT_CentralLib_SendTelemetryItems(items, &timeStamp)) {
                 isNetworkAlive = IoT_CentralLib_CheckConnection();
                 if (isNetworkAlive) {
                     // !!error
@@ -137,43 +228,257 @@ DataFetchScheduler_Schedule(DataFetchScheduler* me)
 
         if (! isNetworkAlive) {
 do_cache:
-            if (! IoT_CentralLib_EnqueueTelemtryItemsToCache(me->mTelemetryItems,
+            if (! IoT_CentralLib_EnqueueTelemtryItemsToCache(items,
                     timeStamp)) {
                 // failed to caching; Error!
             }
         }
+    }
+}
+
+static void
+DataFetchScheduler_Publish(DataFetchScheduler* me)
+{
+    // hand the acquired items over to the main thread by swapping them
+    // with an empty batch (dropped if the main thread doesn't keep up)
+    // (runs on the field bus thread)
+    FetchBatch*	batch;
+    TelemetryItems*	items;
+
+    if (0 == TelemetryItems_Count(me->mTelemetryItems)) {
+        return;
+    }
+    batch = (FetchBatch*)SpscRing_Pop(sFreeBatches);
+    if (NULL == batch) {
+        Log_Debug("WARNING: telemetry batch is dropped, as main thread is busy\n");
         TelemetryItems_Clear(me->mTelemetryItems);
+        return;
+    }
+    items = batch->items;
+    batch->scheduler    = me;
+    batch->items        = me->mTelemetryItems;
+    me->mTelemetryItems = items;
+
+    SpscRing_Push(sAcquiredBatches, batch);  // (never full; as many as batches)
+    if (0 != eventfd_write(sBatchEventFd, 1)) {
+        Log_Debug("ERROR: failed to notify telemetry batch: %s (%d).\n",
+            strerror(errno), errno);
+    }
+}
+
+static void
+DataFetchScheduler_BatchEventHandler(EventLoop* el, int fd,
+    EventLoop_IoEvents events, void* context)
+{
+    // deliver the batches acquired by the field bus thread
+    // (runs on the main thread)
+    eventfd_t	value;
+    FetchBatch*	batch;
+
+    if (0 != eventfd_read(fd, &value) && EAGAIN != errno) {
+        Log_Debug("ERROR: failed to read telemetry batch event: %s (%d).\n",
+            strerror(errno), errno);
+    }
+    while (NULL != (batch = (FetchBatch*)SpscRing_Pop(sAcquiredBatches))) {
+        DataFetchScheduler_Deliver(batch->scheduler, batch->items);
+        TelemetryItems_Clear(batch->items);
+        SpscRing_Push(sFreeBatches, batch);
+    }
+}
+
+static bool
+DataFetchScheduler_SetupBatches(void)
+{
+    // create the batches shared by all schedulers
+    sFreeBatches     = SpscRing_New(FETCH_BATCH_NUM);
+    sAcquiredBatches = SpscRing_New(FETCH_BATCH_NUM);
+    sBatchEventFd    = eventfd(0, EFD_NONBLOCK);
+    if (NULL == sFreeBatches || NULL == sAcquiredBatches || 0 > sBatchEventFd) {
+        goto err;
+    }
+    for (int i = 0; i < FETCH_BATCH_NUM; i++) {
+        sBatches[i].scheduler = NULL;
+        sBatches[i].items     = TelemetryItems_New();
+        if (NULL == sBatches[i].items) {
+            goto err;
+        }
+        SpscRing_Push(sFreeBatches, &sBatches[i]);
+    }
+
+    return true;
+err:
+    Log_Debug("ERROR: failed to setup telemetry batches\n");
+    return false;
+}
+
+static void
+DataFetchScheduler_CleanupBatches(void)
+{
+    if (NULL != sBatchEventReg) {
+        EventLoop_UnregisterIo(sMainLoop, sBatchEventReg);
+        sBatchEventReg = NULL;
+    }
+    if (0 <= sBatchEventFd) {
+        close(sBatchEventFd);
+        sBatchEventFd = -1;
+    }
+    for (int i = 0; i < FETCH_BATCH_NUM; i++) {
+        if (NULL != sBatches[i].items) {
+            TelemetryItems_Destroy(sBatches[i].items);
+            sBatches[i].items = NULL;
+        }
+    }
+    if (NULL != sFreeBatches) {
+        SpscRing_Destroy(sFreeBatches);
+        sFreeBatches = NULL;
+    }
+    if (NULL != sAcquiredBatches) {
+        SpscRing_Destroy(sAcquiredBatches);
+        sAcquiredBatches = NULL;
     }
 }
 
+// Callback procedure of FetchTimers
+static void
+DataFetchScheduler_FetchTimersExpired(void* arg)
+{
+    // acquire the targets of the expired timers
+    DataFetchScheduler_Schedule((DataFetchScheduler*)arg);
+}
+
+// Initialization and cleanup
+void
+DataFetchScheduler_Init(DataFetchScheduler* me, vector fetchItemPtrs)
+{
+    // (called with FieldBusWorker locked)
+    // register the keys of statistics at the first initialization
+    if (NULL == me->mStatsKeys[0]) {
+        char	nameBuf[TELEMETRY_NAME_MAX_LEN + 1];
+
+        for (int i = 0; i < FETCH_STATS_NUM; i++) {
+            snprintf(nameBuf, sizeof(nameBuf), "%s%s",
+                me->mStatsPrefix, sStatsSuffixes[i]);
+            me->mStatsKeys[i] = TelemetryItems_AddDictionaryElem(
+                nameBuf, TELEMETRY_TYPE_UINT32);
+        }
+    }
+    if (NULL == me->mRTStatsKeys[0]
+        && DataFetchSchedulerBase_ReadRTAppStats != me->ReadRTAppStats) {
+        char	nameBuf[TELEMETRY_NAME_MAX_LEN + 1];
+
+        for (int i = 0; i < RTAPP_STATS_NUM; i++) {
+            snprintf(nameBuf, sizeof(nameBuf), "%s%s",
+                me->mStatsPrefix, sRTStatsSuffixes[i]);
+            me->mRTStatsKeys[i] = TelemetryItems_AddDictionaryElem(
+                nameBuf, TELEMETRY_TYPE_UINT32);
+        }
+    }
+
+    // do for specialized/derived class and  
+    // initialize the generalized/base class's member
+    me->DoInit((DataFetchSchedulerBase*)me, fetchItemPtrs);
+
+    FetchTimers_Init(me->mFetchTimers, me->GetTimerTargets(me, fetchItemPtrs));
+    TelemetryItems_Clear(me->mTelemetryItems);
+
+    // set first instance as primary
+    if (NULL == sPrimaryScheduler) {
+        sPrimaryScheduler = me;
+    }
+}
+
+void
+DataFetchScheduler_Destroy(DataFetchScheduler* me)
+{
+    // cleanup member of specialized class and generalized class
+    // (FieldBusWorker has been stopped)
+    me->DoDestroy(me);
+
+    TelemetryItems_Destroy(me->mTelemetryItems);
+    FetchTimers_Destroy(me->mFetchTimers);
+
+    free(me);
+
+    if (0 == --sSchedulerCount) {
+        DataFetchScheduler_CleanupBatches();
+    }
+}
+
+// Delivery of the acquired data on the main event loop
+bool
+DataFetchScheduler_StartDelivery(EventLoop* mainLoop)
+{
+    // (called on the main thread before FieldBusWorker starts, because
+    //  EventLoop is not thread safe; the field bus thread only writes
+    //  to the eventfd afterwards)
+    if (0 > sBatchEventFd || NULL != sBatchEventReg) {
+        return true;  // no scheduler, or already started
+    }
+    sMainLoop      = mainLoop;
+    sBatchEventReg = EventLoop_RegisterIo(sMainLoop, sBatchEventFd,
+        EventLoop_Input, DataFetchScheduler_BatchEventHandler, NULL);
+    if (NULL == sBatchEventReg) {
+        Log_Debug("ERROR: failed to register telemetry batch event: %s (%d).\n",
+            strerror(errno), errno);
+        return false;
+    }
+
+    return true;
+}
+
+// Operation on fetch timer expiration
+void
+DataFetchScheduler_Schedule(DataFetchScheduler* me)
+{
+    // Do data acquisition by specialized class and hand it over to the 
+    // main thread, which sends it as telemetry.
+    // (runs on the field bus thread; fetch targets have been added by 
+    //  the timer expiration callback)
+    me->DoSchedule(me);
+    DataFetchScheduler_AddStats(me);
+
+    me->ClearFetchTargets(me);
+    DataFetchScheduler_Publish(me);
+}
+
 // For specialized class
 DataFetchSchedulerBase*
 DataFetchScheduler_InitOnNew(DataFetchSchedulerBase* me,
     FetchTimerCallback ftCallback, IO_Feature feature)
 {
     // initialize generalized class's member
-    me->mFetchTimers = Factory_CreateFetchTimers(feature, ftCallback, me);
-    if (NULL == me->mFetchTimers) {
+    if (0 == sSchedulerCount && ! DataFetchScheduler_SetupBatches()) {
+        DataFetchScheduler_CleanupBatches();
         goto err;
     }
-    me->mTelemetryItems = TelemetryItems_New();
+    me->mFetchTimers = Factory_CreateFetchTimers(feature,
+        ftCallback, DataFetchScheduler_FetchTimersExpired, me);
     if (NULL == me->mFetchTimers) {
-        goto err_delete_fetchTimers;
+        goto err_cleanup_batches;
     }
-    me->mStringBuf = StringBuf_New();
-    if (NULL == me->mStringBuf) {
-        goto err_delete_telemetryItems;
+    me->mTelemetryItems = TelemetryItems_New();
+    if (NULL == me->mTelemetryItems) {
+        goto err_delete_fetchTimers;
     }
+    me->mStatsPrefix = sStatsPrefixes[feature];
+    memset(me->mStatsKeys, 0, sizeof(me->mStatsKeys));
+    memset(me->mRTStatsKeys, 0, sizeof(me->mRTStatsKeys));
+    sSchedulerCount++;
+
     me->DoDestroy         = DataFetchSchedulerBase_DoDestroy;
     me->DoInit            = DataFetchSchedulerBase_DoInit;
+    me->GetTimerTargets   = DataFetchSchedulerBase_GetTimerTargets;
     me->ClearFetchTargets = DataFetchSchedulerBase_ClearFetchTargets;
     me->DoSchedule        = DataFetchSchedulerBase_DoSchedule;
+    me->ReadRTAppStats    = DataFetchSchedulerBase_ReadRTAppStats;
 
     return me;
-err_delete_telemetryItems:
-    TelemetryItems_Destroy(me->mTelemetryItems);
 err_delete_fetchTimers:
     FetchTimers_Destroy(me->mFetchTimers);
+err_cleanup_batches:
+    if (0 == sSchedulerCount) {
+        DataFetchScheduler_CleanupBatches();
+    }
 err:
     free(me);
     return NULL;
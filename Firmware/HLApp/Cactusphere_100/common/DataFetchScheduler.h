@@ -33,24 +33,38 @@
 #include <Factory.h>
 #endif
 
+#include <applibs/eventloop.h>
+
 // forward declaration
 typedef struct DataFetchSchedulerBase	DataFetchSchedulerBase;
 typedef struct FetchTimers	FetchTimers;
-typedef struct StringBuf	StringBuf;
+typedef struct InterCoreStats	InterCoreStats;
 typedef struct TelemetryItems	TelemetryItems;
+typedef struct TelemetryKey	TelemetryKey;
+
+// number of acquisition timing statistics items
+#define FETCH_STATS_NUM	4
+// period of acquisition timing statistics
+#define FETCH_STATS_PERIOD_MS	(10 * 60 * 1000)
+// number of RTApp performance statistics items
+#define RTAPP_STATS_NUM	12
 
 // DataFetchSchedulerBase class's virtual methods and data mebers
 struct DataFetchSchedulerBase {
 // virtual method
     void	(*DoDestroy)(DataFetchSchedulerBase* me);
     void	(*DoInit)(DataFetchSchedulerBase* me, vector fetchItemPtrs);
+    vector	(*GetTimerTargets)(DataFetchSchedulerBase* me, vector fetchItemPtrs);
     void	(*ClearFetchTargets)(DataFetchSchedulerBase* me);
     void	(*DoSchedule)(DataFetchSchedulerBase* me);
+    bool	(*ReadRTAppStats)(DataFetchSchedulerBase* me, InterCoreStats* outStats);
 
 // data member
     FetchTimers*    mFetchTimers;       // timers for data acquistion
-    TelemetryItems* mTelemetryItems;    // vector of telemetry item
-    StringBuf*      mStringBuf;         // for string processing
+    TelemetryItems* mTelemetryItems;    // telemetry items being acquired (field bus thread)
+    const char*     mStatsPrefix;       // telemetry name prefix of statistics
+    const TelemetryKey* mStatsKeys[FETCH_STATS_NUM];  // keys of statistics
+    const TelemetryKey* mRTStatsKeys[RTAPP_STATS_NUM];  // keys of RTApp statistics
 };
 
 // alias type
@@ -61,7 +75,11 @@ extern void	DataFetchScheduler_Init(
     DataFetchScheduler* me, vector fetchItemPtrs);
 extern void	DataFetchScheduler_Destroy(DataFetchScheduler* me);
 
-// Deriodic operation (per 1[sec])
+// Delivery of the acquired data on the main event loop
+// (main thread, after creating the schedulers and before FieldBusWorker_Start)
+extern bool	DataFetchScheduler_StartDelivery(EventLoop* mainLoop);
+
+// Operation on fetch timer expiration (field bus thread)
 extern void	DataFetchScheduler_Schedule(DataFetchScheduler* me);
 
 // For specialized class
@@ -65,25 +65,27 @@ Factory_CreateScheduler(IO_Feature feature)
 
 FetchTimers*
 Factory_CreateFetchTimers(IO_Feature feature,
-    FetchTimerCallback cbProc, void* cbArg)
+    FetchTimerCallback cbProc, FetchTimersExpiredCallback expiredProc, void* cbArg)
 {
     FetchTimers*	newObj = NULL;
 
     switch (feature) {
 #ifdef USE_MODBUS
     case MODBUS_RTU:
-        newObj = FetchTimers_New(cbProc, cbArg);
+        newObj = FetchTimers_New(cbProc, expiredProc, cbArg);
         break;
 #endif
 #ifdef USE_MODBUS_TCP
     case MODBUS_TCP:
-        newObj = FetchTimers_New(cbProc, cbArg);
+        newObj = FetchTimers_New(cbProc, expiredProc, cbArg);
         break;
 #endif
 #ifdef USE_DI
     case DIGITAL_IN:
-        newObj = FetchTimers_New(cbProc, cbArg);
-        newObj->InitForTimer = DI_FetchTimers_InitForTimer;
+        newObj = FetchTimers_New(cbProc, expiredProc, cbArg);
+        if (NULL != newObj) {
+            newObj->InitForTimer = DI_FetchTimers_InitForTimer;
+        }
         break;
 #endif
     default:
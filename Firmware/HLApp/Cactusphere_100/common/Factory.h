@@ -39,6 +39,6 @@ typedef enum IO_Feature {
 
 extern DataFetchSchedulerBase* Factory_CreateScheduler(IO_Feature feature);
 extern FetchTimers* Factory_CreateFetchTimers(IO_Feature feature,
-    FetchTimerCallback cbProc, void* cbArg);
+    FetchTimerCallback cbProc, FetchTimersExpiredCallback expiredProc, void* cbArg);
 
 #endif  // _FACTORY_H_
@@ -25,15 +25,54 @@
 #ifndef _FETCH_ITEM_BASE_H_
 #define _FETCH_ITEM_BASE_H_
 
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
 #ifndef _STDINT_H
 #include <stdint.h>
 #endif
 
 #define TELEMETRY_NAME_MAX_LEN	32
 
+// range of periodic acquisition interval
+#define FETCH_INTERVAL_MS_MIN	10
+#define FETCH_INTERVAL_MS_MAX	(86400 * 1000)
+
+// phase which is assigned to spread items of the same interval evenly
+#define FETCH_PHASE_AUTO	UINT32_MAX
+
+// policy for the periods missed while acquisition was delayed
+// (a late timer fires once, then)
+typedef enum FetchCatchUpPolicy {
+    FETCH_CATCHUP_SKIP = 0,     // skips the missed periods and keeps the phase
+    FETCH_CATCHUP_RESTART,      // restarts the interval from the actual time
+    FETCH_CATCHUP_NUM
+} FetchCatchUpPolicy;
+
+// deadband type of report-by-exception
+typedef enum DeadbandType {
+    DEADBAND_NONE = 0,  // report every acquired value
+    DEADBAND_ABSOLUTE,  // report when the change exceeds the value
+    DEADBAND_PERCENT    // report when the change exceeds the percentage 
+                        // of the last reported value
+} DeadbandType;
+
+// reporting condition
+typedef struct ReportCondition {
+    // report-by-exception
+    DeadbandType    deadbandType;   // deadband type
+    float           deadband;       // deadband value
+    uint32_t        maxSilenceSec;  // max interval without report (0: no limit)
+    // aggregation
+    uint32_t        aggregateWindowSec; // reporting window of aggregates (0: no aggregation)
+    bool            aggregateStddev;    // whether to report standard deviation
+} ReportCondition;
+
 typedef struct FetchItemBase {
     char        telemetryName[TELEMETRY_NAME_MAX_LEN + 1];  // telemetry name
-    uint32_t    intervalSec;    // periodic acquisition interval (in seconds)
+    uint32_t    intervalMs;     // periodic acquisition interval (in milliseconds)
+    uint32_t    phaseMs;        // acquisition phase in the interval (FETCH_PHASE_AUTO: automatic)
+    FetchCatchUpPolicy  catchUp;    // policy for the missed periods
 } FetchItemBase;
 
 #endif  // _FETCH_ITEM_BASE_H_
@@ -24,17 +24,328 @@
 
 #include "FetchTimers.h"
 
-// Initialization
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include <applibs/log.h>
+
+#include "FieldBusWorker.h"
+
+#define SLOT_MASK	(FETCH_TIMER_SLOTS - 1)
+#define WHEEL_SPAN	(1ULL << (FETCH_TIMER_SLOT_BITS * FETCH_TIMER_WHEEL_LEVELS))
+
+//
+// FetchTimers's private procedure/method
+//
+static FetchTimer*
+FetchTimers_TimerAt(FetchTimers* me, int index)
+{
+    return (FetchTimer*)vector_get_data(me->mBody) + index;
+}
+
+static uint64_t
+FetchTimers_GetElapsedMs(const FetchTimers* me)
+{
+    // elapsed time from the wheel's origin
+    struct timespec	now;
+    int64_t	elapsedMs;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsedMs = (int64_t)(now.tv_sec - me->mOrigin.tv_sec) * 1000
+        + (now.tv_nsec - me->mOrigin.tv_nsec) / 1000000;
+
+    return (elapsedMs < 0) ? 0 : (uint64_t)elapsedMs;
+}
+
 static void
-FetchTimer_Init(FetchTimer* me, FetchItemBase* fi)
+FetchTimers_ResetWheel(FetchTimers* me)
 {
-    me->fetchItem   = fi;
-    me->downCounter = fi->intervalSec;
+    memset(me->mWheel, 0xff, sizeof(me->mWheel));  // all -1
+    memset(me->mOccupied, 0, sizeof(me->mOccupied));
+    me->mNow = 0;
+    me->mResume = false;
+    clock_gettime(CLOCK_MONOTONIC, &me->mOrigin);
+
+    memset(&me->mStats, 0, sizeof(me->mStats));
+    me->mStatsStart = 0;
+}
+
+static void
+FetchTimers_Insert(FetchTimers* me, int index)
+{
+    // put the timer into the slot of the lowest level which covers
+    // its expiration
+    FetchTimer*	timer = FetchTimers_TimerAt(me, index);
+    uint64_t	delta;
+    int	level = 0;
+    int	slot;
+
+    if (timer->expiry < me->mNow) {
+        timer->expiry = me->mNow;
+    }
+    delta = timer->expiry - me->mNow;
+    if (delta >= WHEEL_SPAN) {
+        delta = WHEEL_SPAN - 1;  // re-cascaded until it comes into range
+    }
+    while (level < FETCH_TIMER_WHEEL_LEVELS - 1
+        && 0 != (delta >> (FETCH_TIMER_SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    slot = (int)(((me->mNow + delta) >> (FETCH_TIMER_SLOT_BITS * level)) & SLOT_MASK);
+
+    timer->slot = level * FETCH_TIMER_SLOTS + slot;
+    timer->next = me->mWheel[level][slot];
+    me->mWheel[level][slot] = index;
+    me->mOccupied[level] |= 1ULL << slot;
+}
+
+static void
+FetchTimers_Unlink(FetchTimers* me, int index)
+{
+    // remove the timer from the list of its slot
+    FetchTimer*	timer = FetchTimers_TimerAt(me, index);
+    int	level = timer->slot / FETCH_TIMER_SLOTS;
+    int	slot = timer->slot % FETCH_TIMER_SLOTS;
+    int*	link = &me->mWheel[level][slot];
+
+    while (0 <= *link && *link != index) {
+        link = &FetchTimers_TimerAt(me, *link)->next;
+    }
+    if (0 > *link) {
+        return;  // not in the wheel
+    }
+    *link = timer->next;
+    if (0 > me->mWheel[level][slot]) {
+        me->mOccupied[level] &= ~(1ULL << slot);
+    }
+}
+
+static int
+FetchTimers_TakeSlot(FetchTimers* me, int level, int slot)
+{
+    // detach the timer list of the slot
+    int	head = me->mWheel[level][slot];
+
+    me->mWheel[level][slot] = -1;
+    me->mOccupied[level] &= ~(1ULL << slot);
+
+    return head;
+}
+
+static bool
+FetchTimers_GetNextEvent(const FetchTimers* me, uint64_t* outTime)
+{
+    // The next event is the earliest time after now at which a non-empty
+    // slot is reached; expiration on level 0 or cascading on the others.
+    bool	found = false;
+
+    for (int level = 0; level < FETCH_TIMER_WHEEL_LEVELS; level++) {
+        int	shift = FETCH_TIMER_SLOT_BITS * level;
+        uint64_t	base = me->mNow >> shift;
+        uint64_t	occupied = me->mOccupied[level];
+        int	start = (int)((base + 1) & SLOT_MASK);
+        uint64_t	rotated;
+        uint64_t	time;
+
+        if (0 == occupied) {
+            continue;
+        }
+        rotated = (occupied >> start) | (occupied << ((FETCH_TIMER_SLOTS - start) & SLOT_MASK));
+        time = (base + 1 + (uint64_t)__builtin_ctzll(rotated)) << shift;
+        if (! found || time < *outTime) {
+            *outTime = time;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+static void
+FetchTimers_Arm(FetchTimers* me)
+{
+    // arm the timerfd for the next event of the wheel
+    struct itimerspec	spec;
+    uint64_t	next;
+
+    memset(&spec, 0, sizeof(spec));
+    if (me->mResume || FetchTimers_GetNextEvent(me, &next)) {
+        uint64_t	nsec;
+
+        if (me->mResume) {
+            next = me->mNow;  // already passed, so fires at once
+        }
+        nsec = (uint64_t)me->mOrigin.tv_nsec + (next % 1000) * 1000000;
+
+        spec.it_value.tv_sec  = me->mOrigin.tv_sec + (time_t)(next / 1000 + nsec / 1000000000);
+        spec.it_value.tv_nsec = (long)(nsec % 1000000000);
+    }  // else disarm
+    if (0 != timerfd_settime(me->mTimerFd, TFD_TIMER_ABSTIME, &spec, NULL)) {
+        Log_Debug("ERROR: failed to arm fetch timer: %s (%d).\n", strerror(errno), errno);
+    }
+}
+
+static void
+FetchTimers_Rearm(FetchTimers* me, FetchTimer* timer, uint64_t target)
+{
+    // set the next deadline of the expired timer and account its timing
+    // (the deadlines are on the grid from the wheel's origin, 
+    //  so the period doesn't drift by the delay of acquisition,
+    //  unless the fetch item's policy restarts it)
+    uint64_t	lateness = target - timer->expiry;
+    uint64_t	missed = 0;
+
+    if (NULL != timer->fetchItem
+        && FETCH_CATCHUP_RESTART == timer->fetchItem->catchUp
+        && lateness >= timer->intervalMs) {
+        missed = lateness / timer->intervalMs;
+        timer->expiry = target + timer->intervalMs;
+    } else {
+        timer->expiry += timer->intervalMs;
+        if (timer->expiry <= target) {
+            missed = (target - timer->expiry) / timer->intervalMs + 1;
+            timer->expiry += missed * timer->intervalMs;
+        }
+    }
+
+    if (NULL != timer->fetchItem) {
+        me->mStats.fetchCount++;
+        me->mStats.missedCount += (uint32_t)missed;
+        if (lateness > me->mStats.maxLatenessMs) {
+            me->mStats.maxLatenessMs = (uint32_t)lateness;
+        }
+    }
+}
+
+static bool
+FetchTimers_Advance(FetchTimers* me, uint64_t target, uint64_t* outDeadline)
+{
+    // step the wheel through the events up to the target time and
+    // notify the expired timers
+    // (outDeadline: the earliest next deadline of the expired timers)
+    bool	expired = false;
+    uint64_t	next;
+
+    while (FetchTimers_GetNextEvent(me, &next) && next <= target) {
+        int	head;
+
+        me->mNow = next;
+
+        // cascade the slots beginning now, from the highest level
+        for (int level = FETCH_TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+            int	shift = FETCH_TIMER_SLOT_BITS * level;
+
+            if (0 != (me->mNow & ((1ULL << shift) - 1))) {
+                continue;
+            }
+            head = FetchTimers_TakeSlot(me, level, (int)((me->mNow >> shift) & SLOT_MASK));
+            while (0 <= head) {
+                int	nextIndex = FetchTimers_TimerAt(me, head)->next;
+
+                FetchTimers_Insert(me, head);
+                head = nextIndex;
+            }
+        }
+
+        // expire the timers on level 0
+        head = FetchTimers_TakeSlot(me, 0, (int)(me->mNow & SLOT_MASK));
+        while (0 <= head) {
+            FetchTimer*	timer = FetchTimers_TimerAt(me, head);
+            int	nextIndex = timer->next;
+
+            if (timer->expiry <= me->mNow) {
+                if (NULL != timer->fetchItem) {
+                    me->mCallbackProc(me->mCbArg, timer->fetchItem, timer->expiry);
+                }
+                FetchTimers_Rearm(me, timer, target);
+                if (! expired || timer->expiry < *outDeadline) {
+                    *outDeadline = timer->expiry;
+                }
+                expired = true;
+            }
+            FetchTimers_Insert(me, head);
+            head = nextIndex;
+        }
+    }
+    if (me->mNow < target) {
+        me->mNow = target;
+    }
+
+    return expired;
+}
+
+static void
+FetchTimers_AssignPhases(FetchTimers* me)
+{
+    // Set the first expiration to the item's phase. The items without 
+    // explicit phase are spread evenly over the interval among the items
+    // of the same interval, so that they don't fire at once.
+    // (O(n^2), but only on configuration)
+    FetchTimer*	timers = (FetchTimer*)vector_get_data(me->mBody);
+    int	n = vector_size(me->mBody);
+
+    for (int i = 0; i < n; ++i) {
+        FetchTimer*	timer = timers + i;
+        uint32_t	phase = timer->fetchItem->phaseMs;
+
+        if (FETCH_PHASE_AUTO == phase) {
+            int	order = 0;
+            int	count = 0;
+
+            for (int j = 0; j < n; ++j) {
+                if (FETCH_PHASE_AUTO == timers[j].fetchItem->phaseMs
+                    && timers[j].intervalMs == timer->intervalMs) {
+                    if (j < i) {
+                        order++;
+                    }
+                    count++;
+                }
+            }
+            phase = (uint32_t)((uint64_t)timer->intervalMs * order / count);
+        } else {
+            phase %= timer->intervalMs;
+        }
+        timer->expiry = (0 == phase) ? timer->intervalMs : phase;
+    }
+}
+
+static void
+FetchTimers_TimerEventHandler(EventLoop* el, int fd,
+    EventLoop_IoEvents events, void* context)
+{
+    // (runs on the field bus thread)
+    FetchTimers*	me = (FetchTimers*)context;
+    uint64_t	expirations;
+    uint64_t	deadline;
+
+    FieldBusWorker_Lock();
+    if (sizeof(expirations) != read(fd, &expirations, sizeof(expirations))
+        && EAGAIN != errno) {
+        Log_Debug("ERROR: failed to read fetch timer: %s (%d).\n", strerror(errno), errno);
+    }
+
+    if (FetchTimers_Advance(me, FetchTimers_GetElapsedMs(me), &deadline)) {
+        me->mResume = false;
+        me->mExpiredProc(me->mCbArg);
+
+        // overrun if the acquisition ran past the next deadline
+        if (FetchTimers_GetElapsedMs(me) >= deadline) {
+            me->mStats.overrunCount++;
+        }
+    } else if (me->mResume) {
+        me->mResume = false;
+        me->mExpiredProc(me->mCbArg);
+    }
+    FetchTimers_Arm(me);
+    FieldBusWorker_Unlock();
 }
 
 // Initialization and cleanup
 FetchTimers*
-FetchTimers_New(FetchTimerCallback cbProc, void* cbArg)
+FetchTimers_New(FetchTimerCallback cbProc,
+    FetchTimersExpiredCallback expiredProc, void* cbArg)
 {
     // initialize generalized class's member
     FetchTimers*	newObj = (FetchTimers*)malloc(sizeof(FetchTimers));
@@ -42,15 +353,36 @@ FetchTimers_New(FetchTimerCallback cbProc, void* cbArg)
     if (NULL != newObj) {
         newObj->mBody = vector_init(sizeof(FetchTimer));
         if (NULL == newObj->mBody) {
-            free(newObj);
-            return NULL;
+            goto err_free;
+        }
+        newObj->mTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        if (0 > newObj->mTimerFd) {
+            Log_Debug("ERROR: failed to create fetch timer: %s (%d).\n",
+                strerror(errno), errno);
+            goto err_destroy_body;
+        }
+        newObj->mTimerReg = EventLoop_RegisterIo(FieldBusWorker_GetEventLoop(),
+            newObj->mTimerFd, EventLoop_Input, FetchTimers_TimerEventHandler, newObj);
+        if (NULL == newObj->mTimerReg) {
+            Log_Debug("ERROR: failed to register fetch timer: %s (%d).\n",
+                strerror(errno), errno);
+            goto err_close_fd;
         }
         newObj->mCallbackProc = cbProc;
+        newObj->mExpiredProc  = expiredProc;
         newObj->mCbArg        = cbArg;
         newObj->InitForTimer = FetchTimers_IntiForTimer;
+        FetchTimers_ResetWheel(newObj);
     }
 
     return newObj;
+err_close_fd:
+    close(newObj->mTimerFd);
+err_destroy_body:
+    vector_destroy(newObj->mBody);
+err_free:
+    free(newObj);
+    return NULL;
 }
 
 void
@@ -61,14 +393,26 @@ FetchTimers_Init(FetchTimers* me, vector fetchItemPtrs)
     FetchItemBase**	fetchItemCurs = vector_get_data(fetchItemPtrs);
 
     vector_clear(me->mBody);
+    FetchTimers_ResetWheel(me);
     for (int i = 0, n = vector_size(fetchItemPtrs); i < n; ++i) {
         FetchItemBase*	fetchItem = *fetchItemCurs++;
         FetchTimer	pseudo;
 
-        FetchTimer_Init(&pseudo, fetchItem);
+        pseudo.fetchItem  = fetchItem;
+        pseudo.intervalMs = (0 < fetchItem->intervalMs) ?
+            fetchItem->intervalMs : FETCH_INTERVAL_MS_MIN;
+        pseudo.expiry     = pseudo.intervalMs;
+        pseudo.slot       = 0;
+        pseudo.next       = -1;
         vector_add_last(me->mBody, &pseudo);
         me->InitForTimer(me, fetchItem);  // specialized class specific
     }
+    FetchTimers_AssignPhases(me);
+    for (int i = 0, n = vector_size(me->mBody); i < n; ++i) {
+        FetchTimers_Insert(me, i);
+    }
+
+    FetchTimers_Arm(me);
 }
 
 void
@@ -80,22 +424,85 @@ FetchTimers_IntiForTimer(FetchTimers* me, FetchItemBase* fetchItem)
 void
 FetchTimers_Destroy(FetchTimers* me)
 {
+    EventLoop_UnregisterIo(FieldBusWorker_GetEventLoop(), me->mTimerReg);
+    close(me->mTimerFd);
     vector_destroy(me->mBody);
     free(me);
 }
 
-// Updating timer counters for periodic expiration
+// Add the timer which only drives the scheduler periodically
 void
-FetchTimers_UpdateTimers(FetchTimers* me)
+FetchTimers_AddPollTimer(FetchTimers* me, uint32_t intervalMs)
 {
-    // decrement the timer's down counter and fire when it reaches 0
-    FetchTimer*	timerCurs = vector_get_data(me->mBody);
+    FetchTimer	pseudo;
 
+    pseudo.fetchItem  = NULL;
+    pseudo.intervalMs = intervalMs;
+    pseudo.expiry     = FetchTimers_GetElapsedMs(me) + intervalMs;
+    pseudo.slot       = 0;
+    pseudo.next       = -1;
+    vector_add_last(me->mBody, &pseudo);
+    FetchTimers_Insert(me, vector_size(me->mBody) - 1);
+    FetchTimers_Arm(me);
+}
+
+// Change the interval of the fetch item's timer from its last expiration
+void
+FetchTimers_SetInterval(FetchTimers* me,
+    const FetchItemBase* fetchItem, uint32_t intervalMs)
+{
+    // (the next expiration is moved, so a shorter interval takes effect
+    //  at once)
     for (int i = 0, n = vector_size(me->mBody); i < n; ++i) {
-        if (0 == --timerCurs->downCounter) {
-            me->mCallbackProc(me->mCbArg, timerCurs->fetchItem);
-            timerCurs->downCounter = timerCurs->fetchItem->intervalSec;  // reset
+        FetchTimer*	timer = FetchTimers_TimerAt(me, i);
+        uint64_t	last;
+
+        if (timer->fetchItem != fetchItem) {
+            continue;
+        }
+        last = (timer->expiry > timer->intervalMs) ? timer->expiry - timer->intervalMs : 0;
+        FetchTimers_Unlink(me, i);
+        timer->intervalMs = (0 < intervalMs) ? intervalMs : FETCH_INTERVAL_MS_MIN;
+        timer->expiry     = last + timer->intervalMs;
+        if (timer->expiry <= me->mNow) {
+            timer->expiry = me->mNow + 1;  // (the slot of now has been passed)
         }
-        ++timerCurs;
+        FetchTimers_Insert(me, i);
+        FetchTimers_Arm(me);
+        break;
     }
 }
+
+// Elapsed time from the wheel's origin (in milliseconds)
+uint64_t
+FetchTimers_GetNow(const FetchTimers* me)
+{
+    return FetchTimers_GetElapsedMs(me);
+}
+
+// Notify the expiration callback again at the next turn of the event loop,
+// to continue the acquisitions left over
+void
+FetchTimers_Resume(FetchTimers* me)
+{
+    // (when called from the callback, armed after it returns)
+    me->mResume = true;
+    FetchTimers_Arm(me);
+}
+
+// Take and reset the statistics when periodMs has elapsed since the last
+bool
+FetchTimers_TakeStats(FetchTimers* me, uint32_t periodMs, FetchTimerStats* outStats)
+{
+    // (by the clock, as the wheel doesn't advance without timers)
+    uint64_t	now = FetchTimers_GetElapsedMs(me);
+
+    if (now - me->mStatsStart < periodMs) {
+        return false;
+    }
+    *outStats = me->mStats;
+    memset(&me->mStats, 0, sizeof(me->mStats));
+    me->mStatsStart = now;
+
+    return true;
+}
@@ -25,6 +25,18 @@
 #ifndef _FETCH_TIMERS_H_
 #define _FETCH_TIMERS_H_
 
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+#ifndef _TIME_H
+#include <time.h>
+#endif
+
+#include <applibs/eventloop.h>
+
 #ifndef CONTAINERS_VECTOR_H
 #include <vector.h>
 #endif
@@ -33,15 +45,35 @@
 #include <FetchItemBase.h>
 #endif
 
+// hierarchical timer wheel (resolution: 1[ms])
+#define FETCH_TIMER_WHEEL_LEVELS	5
+#define FETCH_TIMER_SLOT_BITS	6
+#define FETCH_TIMER_SLOTS	(1 << FETCH_TIMER_SLOT_BITS)
+
 // timer for periodic data acquisition
 typedef struct FetchTimer {
-    const FetchItemBase* fetchItem;  // telemetry data acquisition spec
-    uint32_t	downCounter;         // down counter for timer expiration
+    const FetchItemBase* fetchItem;  // telemetry data acquisition spec (NULL: poll only)
+    uint32_t	intervalMs;          // expiration interval (in milliseconds)
+    uint64_t	expiry;              // next expiration (wheel time in milliseconds)
+    int	slot;                        // slot in the wheel (level * FETCH_TIMER_SLOTS + slot)
+    int	next;                        // next timer in the same slot (-1: none)
 } FetchTimer;
 
+// statistics of acquisition timing
+typedef struct FetchTimerStats {
+    uint32_t	fetchCount;     // number of acquisitions
+    uint32_t	overrunCount;   // acquisitions which didn't finish by the next deadline
+    uint32_t	missedCount;    // missed periods
+    uint32_t	maxLatenessMs;  // max delay from the deadline
+} FetchTimerStats;
+
 // callback procedure for timer expiration notification
+// (expiryMs: the scheduled expiration on FetchTimers_GetNow()'s time,
+//  which may be earlier than the notification)
 typedef void (*FetchTimerCallback)(
-    void* arg, const FetchItemBase* fetchTarget);
+    void* arg, const FetchItemBase* fetchTarget, uint64_t expiryMs);
+// callback procedure called after notifying all expired timers
+typedef void (*FetchTimersExpiredCallback)(void* arg);
 
 typedef struct FetchTimers	FetchTimers;
 
@@ -52,17 +84,46 @@ struct FetchTimers {
 
 // data member
     vector	mBody;                      // vector of timer
+    int	mWheel[FETCH_TIMER_WHEEL_LEVELS][FETCH_TIMER_SLOTS];
+                                        // first timer index of each slot (-1: empty)
+    uint64_t	mOccupied[FETCH_TIMER_WHEEL_LEVELS];  // bitmap of non-empty slots
+    uint64_t	mNow;                   // current wheel time (in milliseconds)
+    struct timespec	mOrigin;        // monotonic clock at wheel time 0
+    int	mTimerFd;                       // timerfd which drives the wheel
+    EventRegistration*	mTimerReg;      // registration of mTimerFd to FieldBusWorker
+    bool	mResume;                    // notify again without expiration
+    FetchTimerStats	mStats;             // statistics since mStatsStart
+    uint64_t	mStatsStart;            // wheel time when the statistics started
     FetchTimerCallback	mCallbackProc;  // timer expiration notifier
+    FetchTimersExpiredCallback	mExpiredProc;  // notifier after expirations
     void* mCbArg;                       // callback argument
 };
 
 // Initialization and cleanup
-extern FetchTimers*	FetchTimers_New(FetchTimerCallback cbProc, void* cbArg);
+extern FetchTimers*	FetchTimers_New(FetchTimerCallback cbProc,
+    FetchTimersExpiredCallback expiredProc, void* cbArg);
 extern void	FetchTimers_Init(FetchTimers* me, vector fetchItemPtrs);
 extern void	FetchTimers_IntiForTimer(FetchTimers* me, FetchItemBase* fetchItem);
 extern void	FetchTimers_Destroy(FetchTimers* me);
 
-// Updating timer counters for periodic expiration
-extern void	FetchTimers_UpdateTimers(FetchTimers* me);
+// Add the timer which only drives the scheduler periodically
+extern void	FetchTimers_AddPollTimer(FetchTimers* me, uint32_t intervalMs);
+
+// Change the interval of the fetch item's timer from its last expiration
+extern void	FetchTimers_SetInterval(FetchTimers* me,
+    const FetchItemBase* fetchItem, uint32_t intervalMs);
+
+// Elapsed time from the wheel's origin by the monotonic clock (in
+// milliseconds), on which the expirations are scheduled. The wheel itself
+// advances only at its events, so this may be ahead of mNow.
+extern uint64_t	FetchTimers_GetNow(const FetchTimers* me);
+
+// Notify the expiration callback again at the next turn of the event loop,
+// to continue the acquisitions left over
+extern void	FetchTimers_Resume(FetchTimers* me);
+
+// Take and reset the statistics when periodMs has elapsed since the last
+extern bool	FetchTimers_TakeStats(
+    FetchTimers* me, uint32_t periodMs, FetchTimerStats* outStats);
 
 #endif  // _FETCH_TIMERS_H_
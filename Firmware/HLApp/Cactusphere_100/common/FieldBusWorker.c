@@ -0,0 +1,344 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "FieldBusWorker.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <applibs/log.h>
+
+static EventLoop*	sEventLoop = NULL;
+static pthread_mutex_t	sLock;
+static pthread_t	sThread;
+static bool	sIsRunning = false;
+static atomic_bool	sStopRequested;
+static int	sWakeFd = -1;              // eventfd to wake the thread up for stop or jobs
+static EventRegistration*	sWakeReg = NULL;
+static EventLoop*	sMainLoop = NULL;       // event loop of the main thread
+static int	sDoneFd = -1;              // eventfd to notify the main thread of completions
+static EventRegistration*	sDoneReg = NULL;
+
+// job posted by the main thread
+typedef struct FieldBusJob	FieldBusJob;
+struct FieldBusJob {
+    FieldBusWorker_JobProc	jobProc;
+    FieldBusWorker_DoneProc	doneProc;
+    void*	context;
+    FieldBusJob*	next;
+};
+
+// job queue (FIFO) guarded by sJobLock
+typedef struct FieldBusJobQueue {
+    FieldBusJob*	head;
+    FieldBusJob*	tail;
+} FieldBusJobQueue;
+
+static pthread_mutex_t	sJobLock;
+static FieldBusJobQueue	sPendingJobs = { NULL, NULL };  // to be run by the thread
+static FieldBusJobQueue	sDoneJobs    = { NULL, NULL };  // to be completed by the main thread
+
+//
+// FieldBusWorker's private procedure
+//
+static void
+FieldBusWorker_PushJob(FieldBusJobQueue* queue, FieldBusJob* job)
+{
+    job->next = NULL;
+    if (NULL == queue->tail) {
+        queue->head = job;
+    } else {
+        queue->tail->next = job;
+    }
+    queue->tail = job;
+}
+
+static FieldBusJob*
+FieldBusWorker_PopJob(FieldBusJobQueue* queue)
+{
+    FieldBusJob*	job;
+
+    pthread_mutex_lock(&sJobLock);
+    job = queue->head;
+    if (NULL != job) {
+        queue->head = job->next;
+        if (NULL == queue->head) {
+            queue->tail = NULL;
+        }
+    }
+    pthread_mutex_unlock(&sJobLock);
+
+    return job;
+}
+
+static void
+FieldBusWorker_CancelJobs(FieldBusJobQueue* queue)
+{
+    FieldBusJob*	job;
+
+    while (NULL != (job = FieldBusWorker_PopJob(queue))) {
+        job->doneProc(job->context, true);
+        free(job);
+    }
+}
+
+static void
+FieldBusWorker_WakeEventHandler(EventLoop* el, int fd,
+    EventLoop_IoEvents events, void* context)
+{
+    // (runs on the field bus thread)
+    eventfd_t	value;
+    FieldBusJob*	job;
+
+    if (0 != eventfd_read(fd, &value) && EAGAIN != errno) {
+        Log_Debug("ERROR: failed to read field bus wake event: %s (%d).\n",
+            strerror(errno), errno);
+    }
+
+    // run the posted jobs, and pass them to the main thread to complete
+    while (! atomic_load(&sStopRequested)
+        && NULL != (job = FieldBusWorker_PopJob(&sPendingJobs))) {
+        FieldBusWorker_Lock();
+        job->jobProc(job->context);
+        FieldBusWorker_Unlock();
+
+        pthread_mutex_lock(&sJobLock);
+        FieldBusWorker_PushJob(&sDoneJobs, job);
+        pthread_mutex_unlock(&sJobLock);
+        if (0 != eventfd_write(sDoneFd, 1)) {
+            Log_Debug("ERROR: failed to notify field bus job: %s (%d).\n",
+                strerror(errno), errno);
+        }
+    }
+}
+
+static void
+FieldBusWorker_DoneEventHandler(EventLoop* el, int fd,
+    EventLoop_IoEvents events, void* context)
+{
+    // (runs on the main thread)
+    eventfd_t	value;
+    FieldBusJob*	job;
+
+    if (0 != eventfd_read(fd, &value) && EAGAIN != errno) {
+        Log_Debug("ERROR: failed to read field bus job event: %s (%d).\n",
+            strerror(errno), errno);
+    }
+    while (NULL != (job = FieldBusWorker_PopJob(&sDoneJobs))) {
+        job->doneProc(job->context, false);
+        free(job);
+    }
+}
+
+static void*
+FieldBusWorker_Main(void* arg)
+{
+    while (! atomic_load(&sStopRequested)) {
+        EventLoop_Run_Result result = EventLoop_Run(sEventLoop, -1, true);
+
+        if (result == EventLoop_Run_Failed && errno != EINTR) {
+            Log_Debug("ERROR: field bus event loop failed: %s (%d).\n",
+                strerror(errno), errno);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+// Initialization and cleanup (before creating the schedulers and after
+// destroying them)
+bool
+FieldBusWorker_Initialize(void)
+{
+    pthread_mutexattr_t	attr;
+
+    atomic_init(&sStopRequested, false);
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&sLock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    pthread_mutex_init(&sJobLock, NULL);
+
+    sEventLoop = EventLoop_Create();
+    if (NULL == sEventLoop) {
+        Log_Debug("ERROR: could not create field bus event loop.\n");
+        return false;
+    }
+    sWakeFd = eventfd(0, EFD_NONBLOCK);
+    if (0 > sWakeFd) {
+        Log_Debug("ERROR: failed to create field bus wake event: %s (%d).\n",
+            strerror(errno), errno);
+        goto err_close_loop;
+    }
+    sDoneFd = eventfd(0, EFD_NONBLOCK);
+    if (0 > sDoneFd) {
+        Log_Debug("ERROR: failed to create field bus job event: %s (%d).\n",
+            strerror(errno), errno);
+        goto err_close_fd;
+    }
+    sWakeReg = EventLoop_RegisterIo(sEventLoop, sWakeFd,
+        EventLoop_Input, FieldBusWorker_WakeEventHandler, NULL);
+    if (NULL == sWakeReg) {
+        Log_Debug("ERROR: failed to register field bus wake event: %s (%d).\n",
+            strerror(errno), errno);
+        goto err_close_fd;
+    }
+
+    return true;
+err_close_fd:
+    if (0 <= sDoneFd) {
+        close(sDoneFd);
+        sDoneFd = -1;
+    }
+    close(sWakeFd);
+    sWakeFd = -1;
+err_close_loop:
+    EventLoop_Close(sEventLoop);
+    sEventLoop = NULL;
+    return false;
+}
+
+void
+FieldBusWorker_Cleanup(void)
+{
+    FieldBusWorker_Stop();
+    FieldBusWorker_CancelJobs(&sDoneJobs);
+    FieldBusWorker_CancelJobs(&sPendingJobs);
+    if (NULL != sEventLoop) {
+        EventLoop_UnregisterIo(sEventLoop, sWakeReg);
+        close(sWakeFd);
+        close(sDoneFd);
+        EventLoop_Close(sEventLoop);
+        sEventLoop = NULL;
+    }
+    pthread_mutex_destroy(&sJobLock);
+    pthread_mutex_destroy(&sLock);
+}
+
+// Start and stop the thread (the job completions are notified on mainLoop)
+bool
+FieldBusWorker_Start(EventLoop* mainLoop)
+{
+    int	err;
+
+    if (sIsRunning || NULL == sEventLoop) {
+        return sIsRunning;
+    }
+    sDoneReg = EventLoop_RegisterIo(mainLoop, sDoneFd,
+        EventLoop_Input, FieldBusWorker_DoneEventHandler, NULL);
+    if (NULL == sDoneReg) {
+        Log_Debug("ERROR: failed to register field bus job event: %s (%d).\n",
+            strerror(errno), errno);
+        return false;
+    }
+    sMainLoop = mainLoop;
+    atomic_store(&sStopRequested, false);
+    err = pthread_create(&sThread, NULL, FieldBusWorker_Main, NULL);
+    if (0 != err) {
+        Log_Debug("ERROR: failed to start field bus thread: %s (%d).\n",
+            strerror(err), err);
+        EventLoop_UnregisterIo(sMainLoop, sDoneReg);
+        sDoneReg = NULL;
+        return false;
+    }
+    sIsRunning = true;
+
+    // run the jobs posted before starting
+    if (0 != eventfd_write(sWakeFd, 1)) {
+        Log_Debug("ERROR: failed to wake field bus thread: %s (%d).\n",
+            strerror(errno), errno);
+    }
+
+    return true;
+}
+
+void
+FieldBusWorker_Stop(void)
+{
+    if (! sIsRunning) {
+        return;
+    }
+    atomic_store(&sStopRequested, true);
+    if (0 != eventfd_write(sWakeFd, 1)) {
+        Log_Debug("ERROR: failed to wake field bus thread: %s (%d).\n",
+            strerror(errno), errno);
+    }
+    pthread_join(sThread, NULL);
+    sIsRunning = false;
+    EventLoop_UnregisterIo(sMainLoop, sDoneReg);
+    sDoneReg = NULL;
+}
+
+// Event loop which the thread runs
+EventLoop*
+FieldBusWorker_GetEventLoop(void)
+{
+    return sEventLoop;
+}
+
+// Post the job to the field bus thread
+bool
+FieldBusWorker_PostJob(FieldBusWorker_JobProc jobProc,
+    FieldBusWorker_DoneProc doneProc, void* context)
+{
+    FieldBusJob*	job = (FieldBusJob*)malloc(sizeof(FieldBusJob));
+
+    if (NULL == job) {
+        return false;
+    }
+    job->jobProc  = jobProc;
+    job->doneProc = doneProc;
+    job->context  = context;
+    pthread_mutex_lock(&sJobLock);
+    FieldBusWorker_PushJob(&sPendingJobs, job);
+    pthread_mutex_unlock(&sJobLock);
+    if (sIsRunning && 0 != eventfd_write(sWakeFd, 1)) {
+        Log_Debug("ERROR: failed to wake field bus thread: %s (%d).\n",
+            strerror(errno), errno);
+    }
+
+    return true;
+}
+
+// Exclusive access to the field bus and the acquisition configuration
+// (the thread holds it while acquiring and running the jobs; recursive;
+//  only for the field bus thread, the main thread posts jobs instead)
+void
+FieldBusWorker_Lock(void)
+{
+    pthread_mutex_lock(&sLock);
+}
+
+void
+FieldBusWorker_Unlock(void)
+{
+    pthread_mutex_unlock(&sLock);
+}
@@ -0,0 +1,66 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _FIELD_BUS_WORKER_H_
+#define _FIELD_BUS_WORKER_H_
+
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+
+#include <applibs/eventloop.h>
+
+// Thread which runs the field bus I/O (the fetch timers of the schedulers),
+// so that the bus latency doesn't delay the communication with the cloud.
+
+// Initialization and cleanup (before creating the schedulers and after
+// destroying them)
+extern bool	FieldBusWorker_Initialize(void);
+extern void	FieldBusWorker_Cleanup(void);
+
+// Start and stop the thread (the job completions are notified on mainLoop)
+extern bool	FieldBusWorker_Start(EventLoop* mainLoop);
+extern void	FieldBusWorker_Stop(void);
+
+// Event loop which the thread runs
+extern EventLoop*	FieldBusWorker_GetEventLoop(void);
+
+// Job which accesses the field bus on behalf of the main thread.
+// jobProc runs on the field bus thread, and then doneProc runs on the
+// main thread's event loop to return the result. doneProc also releases
+// the context; isCancelled is true if the job was discarded without running.
+typedef void	(*FieldBusWorker_JobProc)(void* context);
+typedef void	(*FieldBusWorker_DoneProc)(void* context, bool isCancelled);
+
+extern bool	FieldBusWorker_PostJob(FieldBusWorker_JobProc jobProc,
+    FieldBusWorker_DoneProc doneProc, void* context);
+
+// Exclusive access to the field bus and the acquisition configuration
+// (the thread holds it while acquiring and running the jobs; recursive;
+//  only for the field bus thread, the main thread posts jobs instead)
+extern void	FieldBusWorker_Lock(void);
+extern void	FieldBusWorker_Unlock(void);
+
+#endif  // _FIELD_BUS_WORKER_H_
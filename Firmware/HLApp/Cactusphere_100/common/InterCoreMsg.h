@@ -0,0 +1,137 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _INTER_CORE_MSG_H_
+#define _INTER_CORE_MSG_H_
+
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+// version of the intercore protocol
+#define INTERCORE_PROTOCOL_VERSION	2
+
+// request flags
+#define INTERCORE_FLAG_NO_REPLY	0x01  // RTApp doesn't send back the reply
+#define INTERCORE_FLAG_SAMPLES 	0x02  // unsolicited sample batch (RTApp to HLApp)
+
+// status code of reply
+enum {
+    INTERCORE_STATUS_OK          = 0,  // processed (result is in the payload)
+    INTERCORE_STATUS_BAD_REQUEST = 1,  // invalid length or version
+    INTERCORE_STATUS_UNKNOWN     = 2,  // unknown request code
+    INTERCORE_STATUS_NOT_READY   = 3,  // device isn't set up yet
+};
+
+//
+// message header
+//  precedes every request and reply, followed by the payload
+//  (the driver message or its reply); a reply has the same sequence
+//  number as its request
+//
+typedef struct InterCoreMsgHdr {
+    uint8_t 	version;     // INTERCORE_PROTOCOL_VERSION
+    uint8_t 	flags;       // INTERCORE_FLAG_xx (request)
+    uint16_t	status;      // INTERCORE_STATUS_xx (reply)
+    uint32_t	seq;         // sequence number
+    uint32_t	payloadLen;  // length of the payload
+} InterCoreMsgHdr;
+
+//
+// sample stream
+//  RTApp appends fixed-size records to its sample ring and sends them in
+//  batches flagged with INTERCORE_FLAG_SAMPLES; the sequence number of a
+//  batch is counted separately from the requests, so that a lost batch
+//  can be detected
+//
+// kind of sample
+enum {
+    INTERCORE_SAMPLE_DI_EDGE = 1,  // settled edge of DI pin (value: new level)
+    INTERCORE_SAMPLE_MODBUS_REG   = 2,  // register read by the poll plan
+                                        // (source: entry << 8 | register offset,
+                                        //  value: register | INTERCORE_SAMPLE_LAST_REG)
+    INTERCORE_SAMPLE_MODBUS_ERROR = 3,  // transaction of the poll plan failed
+                                        // (source: entry << 8, value: INTERCORE_MODBUS_ERR_xx)
+};
+
+// flag of the last register in a transaction (INTERCORE_SAMPLE_MODBUS_REG)
+#define INTERCORE_SAMPLE_LAST_REG	0x10000
+
+// error of INTERCORE_SAMPLE_MODBUS_ERROR
+enum {
+    INTERCORE_MODBUS_ERR_TIMEOUT  = 1,  // no response
+    INTERCORE_MODBUS_ERR_RESPONSE = 2,  // invalid response (address, function, length or CRC)
+};
+
+// sample record
+typedef struct InterCoreSample {
+    uint32_t	timestamp;  // time of RTApp [usec] (wraps around)
+    uint16_t	source;     // source of the sample (e.g. DI pin ID)
+    uint16_t	kind;       // INTERCORE_SAMPLE_xx
+    uint32_t	value;
+} InterCoreSample;
+
+// payload of sample batch (followed by count records)
+typedef struct InterCoreSampleBatch {
+    uint32_t	dropped;    // samples dropped by RTApp since the previous batch
+    uint32_t	count;      // number of records
+} InterCoreSampleBatch;
+
+// max number of records in a batch
+#define INTERCORE_SAMPLE_BATCH_MAX	32
+
+//
+// performance statistics
+//  RTApp counts the requests and its driver's events, and records their
+//  durations in log2 histograms; HLApp reads them by the stats request
+//  of each driver (UART_REQ_STATS, DI_READ_STATS)
+//
+// number of histogram bins
+//  (bin n: [2^n, 2^(n+1)) [usec], bin 0 includes 0 and the last bin
+//   includes all above)
+#define INTERCORE_HIST_BINS	20
+
+// log2 histogram of durations
+typedef struct InterCoreHist {
+    uint32_t	count;
+    uint32_t	maxUs;
+    uint32_t	bins[INTERCORE_HIST_BINS];
+} InterCoreHist;
+
+// reply of the stats request
+typedef struct InterCoreStats {
+    uint32_t	periodMs;       // time since the last reset
+    uint32_t	requests;       // requests received
+    uint32_t	rejected;       // requests replied with an error status
+    uint32_t	samplesDropped; // samples dropped as the ring was full
+    uint32_t	events;         // RS485: UART transactions, DI: timer interrupts
+    uint32_t	timeouts;       // RS485: no response, DI: missed timer interrupts
+    uint32_t	txBytes;        // RS485: bytes sent on the bus
+    uint32_t	rxBytes;        // RS485: bytes received from the bus
+    InterCoreHist	requestUs;  // processing time of the requests
+    InterCoreHist	eventUs;    // RS485: transaction latency, DI: interrupt handler duration
+} InterCoreStats;
+
+#endif  // _INTER_CORE_MSG_H_
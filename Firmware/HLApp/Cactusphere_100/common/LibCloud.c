@@ -25,7 +25,9 @@
 #include "LibCloud.h"
 
 #include <errno.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 
 #include <applibs/log.h>
@@ -38,28 +40,101 @@
 #include <iothub.h>
 #include <azure_sphere_provisioning.h>
 
-#include "vector.h"
-
 #include "TelemetryItemCache.h"
 #include "TelemetryItems.h"
 
 #define RESEND_MAX_NUM	10
+#define WAITING_MSG_MAX	32	// maximum number of in-flight telemetry messages
+#define WAITING_MSG_INDEX_BITS	8	// bits of slot index in send callback context
 
 extern IOTHUB_DEVICE_CLIENT_LL_HANDLE Get_IOTHUB_DEVICE_CLIENT_LL_HANDLE(void); // main.c
 
-static int  IoT_CentralLib_FindWaitingMsg(IOTHUB_MESSAGE_HANDLE msgHandle);
-
+// in-flight telemetry message slot
 typedef struct TelemetryMsgInfo {
     IOTHUB_MESSAGE_HANDLE   msgHandle;
     uint32_t    timeStamp;
+    TelemetryItems* items;  // telemetry data items carried by the message
+    bool        inUse;      // whether the slot is in use
+    uintptr_t   generation; // incremented whenever the slot is released
+    int         nextFree;   // index of next free slot (only for free slot)
 } TelemetryMsgInfo;
 
 static IOTHUB_DEVICE_CLIENT_LL_HANDLE sIothubClientHandle = NULL;
 static TelemetryItemCache*	sTelemetryCache = NULL;
-static TelemetryItems*	sTelemetryItems = NULL;
-static vector   sWaitingMsgs = NULL;
+static TelemetryMsgInfo	sWaitingMsgs[WAITING_MSG_MAX];
+static int	sFreeMsgSlot = -1;  // head of free slot list, -1 if all in use
+static char*	sJsonBuf = NULL;    // JSON text buffer for telemetry message
+static size_t	sJsonBufSize = 0;
 static time_t	sBaseTime;
 
+static void
+IoT_CentralLib_ResetWaitingMsgs(void)
+{
+    // destroy outstanding messages and link all slots into free list
+    for (int i = 0; i < WAITING_MSG_MAX; ++i) {
+        TelemetryMsgInfo*	theMsg = &sWaitingMsgs[i];
+
+        if (NULL != theMsg->msgHandle) {
+            IoTHubMessage_Destroy(theMsg->msgHandle);
+            theMsg->msgHandle = NULL;
+        }
+        if (NULL != theMsg->items) {
+            TelemetryItems_Clear(theMsg->items);
+        }
+        theMsg->inUse    = false;
+        ++theMsg->generation;
+        theMsg->nextFree = (WAITING_MSG_MAX - 1 > i) ? i + 1 : -1;
+    }
+    sFreeMsgSlot = 0;
+}
+
+static int
+IoT_CentralLib_AllocWaitingMsg(uint32_t timeStamp)
+{
+    int	theIndex = sFreeMsgSlot;
+
+    if (0 <= theIndex) {
+        TelemetryMsgInfo*	theMsg = &sWaitingMsgs[theIndex];
+
+        sFreeMsgSlot      = theMsg->nextFree;
+        theMsg->msgHandle = NULL;
+        theMsg->timeStamp = timeStamp;
+        theMsg->inUse     = true;
+    }
+
+    return theIndex;
+}
+
+static void
+IoT_CentralLib_ReleaseWaitingMsg(int index, bool requeue)
+{
+    // if requested, return the message's telemetry data items to cache 
+    // as they are, then put the slot back to free list
+    TelemetryMsgInfo*	theMsg = &sWaitingMsgs[index];
+
+    if (requeue && 0 != TelemetryItems_Count(theMsg->items)) {
+        (void)TelemetryItemCache_EnqueueItems(
+            sTelemetryCache, theMsg->items, theMsg->timeStamp);
+    }
+    if (NULL != theMsg->msgHandle) {
+        IoTHubMessage_Destroy(theMsg->msgHandle);
+        theMsg->msgHandle = NULL;
+    }
+    TelemetryItems_Clear(theMsg->items);
+    theMsg->inUse    = false;
+    ++theMsg->generation;
+    theMsg->nextFree = sFreeMsgSlot;
+    sFreeMsgSlot     = index;
+}
+
+static void*
+IoT_CentralLib_MsgContext(int index)
+{
+    // slot index in the low bits, the slot's generation in the high bits
+    return (void*)((sWaitingMsgs[index].generation << WAITING_MSG_INDEX_BITS)
+        | (uintptr_t)index);
+}
+
 /// <summary>
 ///     Callback confirming message delivered to IoT Hub.
 /// </summary>
@@ -68,26 +143,20 @@ static time_t	sBaseTime;
 static void
 SendMessageCallback(IOTHUB_CLIENT_CONFIRMATION_RESULT result, void *context)
 {
-    int theIndex =
-        IoT_CentralLib_FindWaitingMsg((IOTHUB_MESSAGE_HANDLE)context);
+    // context holds the index and generation of in-flight message slot;
+    // a late confirmation for a slot which has been released (and may be
+    // reused) since the message was sent doesn't match the generation
+    int theIndex = (int)((uintptr_t)context
+        & (((uintptr_t)1 << WAITING_MSG_INDEX_BITS) - 1));
 
     Log_Debug("INFO: Message received by IoT Hub. Result is: %d\n", result);
-    if (0 <= theIndex) {
-        if (IOTHUB_CLIENT_CONFIRMATION_OK != result) {
-            const TelemetryMsgInfo*   theMsg =
-                (TelemetryMsgInfo*)vector_get_data(sWaitingMsgs) + theIndex;
-            const char* jsonStr = IoTHubMessage_GetString(theMsg->msgHandle);
-
-            if (TelemetryItems_LoadFromJson(sTelemetryItems, jsonStr)) {
-                (void)TelemetryItemCache_EnqueueItems(
-                    sTelemetryCache, sTelemetryItems, theMsg->timeStamp);
-            }
-        }
-        vector_remove_at(sWaitingMsgs, theIndex);
+    if (WAITING_MSG_MAX > theIndex && sWaitingMsgs[theIndex].inUse
+        && IoT_CentralLib_MsgContext(theIndex) == context) {
+        IoT_CentralLib_ReleaseWaitingMsg(theIndex,
+            IOTHUB_CLIENT_CONFIRMATION_OK != result);
     } else {
         Log_Debug("WARN: Unknown essage on  SendMessageCallback().\n");
     }
-    IoTHubMessage_Destroy((IOTHUB_MESSAGE_HANDLE)context);
 }
 
 static uint32_t
@@ -114,55 +183,57 @@ MakeDateTimeStr(char* strBuf, size_t bufSize, uint32_t timeStamp)
 //       in the character string returned as an output argument.
 }
 
-static int
-IoT_CentralLib_FindWaitingMsg(IOTHUB_MESSAGE_HANDLE msgHandle)
+static const char*
+IoT_CentralLib_ToJson(const TelemetryItems* items)
 {
-    TelemetryMsgInfo*   curs =
-        (TelemetryMsgInfo*)vector_get_data(sWaitingMsgs);
+    // JSON text buffer is reused and only grows when it's not enough
+    size_t	sizeMax = TelemetryItems_GetJsonSizeMax(items);
+
+    if (sJsonBufSize < sizeMax) {
+        size_t	newSize = (sJsonBufSize * 2 > sizeMax) ? sJsonBufSize * 2 : sizeMax;
+        char*	newBuf = (char*)realloc(sJsonBuf, newSize);
 
-    for (int i = 0, n = vector_size(sWaitingMsgs); i < n; ++i) {
-        if ((curs++)->msgHandle == msgHandle) {
-            return i;
+        if (NULL == newBuf) {
+            Log_Debug("WARNING: unable to allocate JSON text buffer\n");
+            return NULL;
         }
+        sJsonBuf     = newBuf;
+        sJsonBufSize = newSize;
     }
+    (void)TelemetryItems_ToJson(items, sJsonBuf, sJsonBufSize);
 
-    return -1;
+    return sJsonBuf;
 }
 
 static bool
-IoT_CentralLib_DoSendTelemetry(const char* jsonStr, uint32_t timeStamp)
+IoT_CentralLib_DoSendTelemetry(int index, const char* jsonStr, bool requeue)
 {
-    // send telemetry data message to IoT Central with timestamp property
-    bool	isOK = true;
+    // send telemetry data message in the slot to IoT Central 
+    // with timestamp property
+    TelemetryMsgInfo*	theMsg = &sWaitingMsgs[index];
     char	strBuf[64];
-    IOTHUB_MESSAGE_HANDLE messageHandle = IoTHubMessage_CreateFromString(jsonStr);
-    TelemetryMsgInfo    msgInfo;
 
-    if (messageHandle == 0) {
+    if (NULL != jsonStr) {
+        theMsg->msgHandle = IoTHubMessage_CreateFromString(jsonStr);
+    }
+    if (theMsg->msgHandle == 0) {
         Log_Debug("WARNING: unable to create a new IoTHubMessage\n");
+        IoT_CentralLib_ReleaseWaitingMsg(index, requeue);
         return false;
     }
-    MakeDateTimeStr(strBuf, sizeof(strBuf), timeStamp);
-    IoTHubMessage_SetProperty(messageHandle, "iothub-creation-time-utc", strBuf);
-    msgInfo.msgHandle = messageHandle;
-    msgInfo.timeStamp = timeStamp;
-    vector_add_last(sWaitingMsgs, &msgInfo);
+    MakeDateTimeStr(strBuf, sizeof(strBuf), theMsg->timeStamp);
+    IoTHubMessage_SetProperty(theMsg->msgHandle, "iothub-creation-time-utc", strBuf);
     if (IoTHubDeviceClient_LL_SendEventAsync(
-            sIothubClientHandle, messageHandle, SendMessageCallback, messageHandle)
+            sIothubClientHandle, theMsg->msgHandle, SendMessageCallback,
+            IoT_CentralLib_MsgContext(index))
         != IOTHUB_CLIENT_OK) {
-        int theIndex = IoT_CentralLib_FindWaitingMsg(messageHandle);
-
-        isOK = false;
-        if (0 <= theIndex) {
-            (void)vector_remove_at(sWaitingMsgs, theIndex);
-            IoTHubMessage_Destroy(messageHandle);
-        }
+        IoT_CentralLib_ReleaseWaitingMsg(index, requeue);
         Log_Debug("WARNING: failed to hand over the message to IoTHubClient\n");
-    } else {
-        Log_Debug("INFO: IoTHubClient accepted the message for delivery\n");
+        return false;
     }
+    Log_Debug("INFO: IoTHubClient accepted the message for delivery\n");
 
-    return isOK;
+    return true;
 }
 
 // Initialization and cleanup
@@ -183,24 +254,16 @@ IoT_CentralLib_Initialize(
         sBaseTime = time(NULL);
     }
 
-    if (NULL == sTelemetryItems) {
-        sTelemetryItems = TelemetryItems_New();
-        if (NULL == sTelemetryItems) {
-            return false;
+    for (int i = 0; i < WAITING_MSG_MAX; ++i) {
+        if (NULL == sWaitingMsgs[i].items) {
+            sWaitingMsgs[i].items = TelemetryItems_New();
+            if (NULL == sWaitingMsgs[i].items) {
+                return false;
+            }
         }
     }
 
-    if (NULL == sWaitingMsgs) {
-        sWaitingMsgs = vector_init(sizeof(TelemetryMsgInfo));
-    } else if (0 != vector_size(sWaitingMsgs)) {
-        TelemetryMsgInfo* curs =
-            (TelemetryMsgInfo*)vector_get_data(sWaitingMsgs);
-
-        for (int i = 0, n = vector_size(sWaitingMsgs); i < n; ++i) {
-            IoTHubMessage_Destroy(curs->msgHandle);
-            ++curs;
-        }
-    }
+    IoT_CentralLib_ResetWaitingMsgs();
     sIothubClientHandle = Get_IOTHUB_DEVICE_CLIENT_LL_HANDLE();
 
     return (sIothubClientHandle != NULL);
@@ -209,25 +272,18 @@ IoT_CentralLib_Initialize(
 void
 IoT_CentralLib_Cleanup(void)
 {
-    if (NULL != sWaitingMsgs) {
-        TelemetryMsgInfo*   curs =
-            (TelemetryMsgInfo*)vector_get_data(sWaitingMsgs);
-
-        for (int i = 0, n = vector_size(sWaitingMsgs); i < n; ++i) {
-            IoTHubMessage_Destroy(curs->msgHandle);
-            ++curs;
-        }
-        vector_destroy(sWaitingMsgs);
-        sWaitingMsgs = NULL;
-    }
+    IoT_CentralLib_ResetWaitingMsgs();
     if (NULL != sTelemetryCache) {
         TelemetryItemCache_Destroy(sTelemetryCache);
         sTelemetryCache = NULL;
     }
-    if (NULL != sTelemetryItems) {
-        TelemetryItems_Destroy(sTelemetryItems);
-        sTelemetryItems = NULL;
+    for (int i = 0; i < WAITING_MSG_MAX; ++i) {
+        TelemetryItems_Destroy(sWaitingMsgs[i].items);
+        sWaitingMsgs[i].items = NULL;
     }
+    free(sJsonBuf);
+    sJsonBuf     = NULL;
+    sJsonBufSize = 0;
 }
 
 // Send telemetry data
@@ -235,10 +291,45 @@ bool
 IoT_CentralLib_SendTelemetry(const char* jsonStr, uint32_t* outTimestamp)
 {
     uint32_t	timeStamp = GetTimestamp();
+    int theIndex;
+
+    *outTimestamp = timeStamp;
+    theIndex = IoT_CentralLib_AllocWaitingMsg(timeStamp);
+    if (0 > theIndex) {
+        Log_Debug("WARNING: too many messages are waiting for delivery\n");
+        return false;
+    }
+
+    return IoT_CentralLib_DoSendTelemetry(theIndex, jsonStr, false);
+}
+
+bool
+IoT_CentralLib_SendTelemetryItems(
+    const TelemetryItems* telemetryItems, uint32_t* outTimestamp)
+{
+    // keep a copy of the telemetry data items with the message, 
+    // so as to return them to cache if the delivery fails
+    uint32_t	timeStamp = GetTimestamp();
+    TelemetryItems*	msgItems;
+    int theIndex;
 
     *outTimestamp = timeStamp;
+    theIndex = IoT_CentralLib_AllocWaitingMsg(timeStamp);
+    if (0 > theIndex) {
+        Log_Debug("WARNING: too many messages are waiting for delivery\n");
+        return false;
+    }
+    msgItems = sWaitingMsgs[theIndex].items;
+    TelemetryItems_CopyFrom(msgItems, telemetryItems);
+
+    return IoT_CentralLib_DoSendTelemetry(
+        theIndex, IoT_CentralLib_ToJson(msgItems), false);
+}
 
-    return IoT_CentralLib_DoSendTelemetry(jsonStr, timeStamp);
+bool
+IoT_CentralLib_IsSendQueueFull(void)
+{
+    return (0 > sFreeMsgSlot);
 }
 
 // Telemetry data caching during network down
@@ -275,16 +366,24 @@ IoT_CentralLib_ResendCachedTelemetryItems(void)
     }
 
     for (int i = 0; i < RESEND_MAX_NUM; ++i) {
-        uint32_t	timeStamp;
-        const char* jsonStr;
+        // dequeue directly into the message slot
+        int theIndex = IoT_CentralLib_AllocWaitingMsg(0);
+        TelemetryMsgInfo*	theMsg;
 
-        (void)TelemetryItemCache_DequeueItemsTo(
-            sTelemetryCache, sTelemetryItems, &timeStamp);
-        jsonStr = TelemetryItems_ToJson(sTelemetryItems);
-        if (! IoT_CentralLib_DoSendTelemetry(jsonStr, timeStamp)) {
+        if (0 > theIndex) {
+            break;  // retry after some messages are delivered
+        }
+        theMsg = &sWaitingMsgs[theIndex];
+        if (! TelemetryItemCache_DequeueItemsTo(
+                sTelemetryCache, theMsg->items, &theMsg->timeStamp)
+            || 0 == TelemetryItems_Count(theMsg->items)) {
+            IoT_CentralLib_ReleaseWaitingMsg(theIndex, false);
+            continue;  // empty record
+        }
+        if (! IoT_CentralLib_DoSendTelemetry(
+                theIndex, IoT_CentralLib_ToJson(theMsg->items), true)) {
             return false;  // error
         }
-        TelemetryItems_Clear(sTelemetryItems);
 
         if (TelemetryItemCache_IsEmpty(sTelemetryCache)) {
             break;
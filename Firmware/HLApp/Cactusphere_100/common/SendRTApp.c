@@ -25,18 +25,24 @@
 #include "SendRTApp.h"
 
 #include <ctype.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
 #include <signal.h>
-#include <sys/time.h>
+#include <time.h>
 #include <sys/socket.h>
+#include <sys/timerfd.h>
 
 #include <applibs/application.h>
+#include <applibs/eventloop.h>
 #include <applibs/log.h>
 
 #include "cactusphere_product.h"
+#include "FieldBusWorker.h"
+#include "InterCoreMsg.h"
 
 #if (APP_PRODUCT_ID == PRODUCT_ATMARK_TECHNO_DIN)
 static const char rtAppComponentId[] = "c01e5fe8-6c61-4d14-beff-38492b1502b6";  // for DI
@@ -44,52 +50,376 @@ static const char rtAppComponentId[] = "c01e5fe8-6c61-4d14-beff-38492b1502b6";
 static const char rtAppComponentId[] = "c8b178fe-5942-4584-826c-51856ac5e4ff";  // for RS485
 #endif
 
+// request to RTApp
+//  the requests are sent as soon as submitted (RTApp queues them), and
+//  a reply is matched by the sequence number in its header, so a reply
+//  which arrives after the deadline is just discarded.
+typedef struct SendRTAppRequest {
+    uint32_t	id;         // request ID = sequence number (0: free slot)
+    bool	isSent;         // sent to RTApp and waiting the reply
+    uint64_t	deadlineMs; // deadline (CLOCK_MONOTONIC)
+    long	txSize;         // including the header
+    long	rxSize;
+    SendRTAppCallback	callback;
+    void*	context;
+    unsigned char	txMessage[sizeof(InterCoreMsgHdr) + SENDRTAPP_MESSAGE_MAX];
+} SendRTAppRequest;
+
+// context of synchronous request
+typedef struct SendRTAppSyncCtx {
+    unsigned char*	rxMessage;
+    long	rxMessageSize;
+    bool	isDone;
+    bool	isOk;
+} SendRTAppSyncCtx;
+
 static int sSockFd = -1;
+static int sTimerFd = -1;
+static EventRegistration*	sSockReg  = NULL;
+static EventRegistration*	sTimerReg = NULL;
+static bool	sWaitOutput = false;   // waiting the socket becomes writable
+static SendRTAppRequest	sRequests[SENDRTAPP_REQUEST_NUM];
+static SendRTAppRequest*	sQueue[SENDRTAPP_REQUEST_NUM];  // in arrival order
+static int	sQueueLen = 0;
+static uint32_t	sNextId = 1;
+static unsigned char	sRxBuf[sizeof(InterCoreMsgHdr) + SENDRTAPP_MESSAGE_MAX];
+static SendRTAppSampleHandler	sSampleHandler = NULL;
+static void*	sSampleContext = NULL;
+static bool	sHasSampleSeq = false;
+static uint32_t	sNextSampleSeq;    // expected sequence number of the next batch
+
+//
+// SendRTApp's private procedure
+//
+static uint64_t
+SendRTApp_GetNowMs(void)
+{
+    struct timespec	now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / (1000 * 1000);
+}
+
+static void
+SendRTApp_ArmTimer(void)
+{
+    struct itimerspec	spec;
+    uint64_t	earliest = 0;
+
+    for (int i = 0; i < sQueueLen; i++) {
+        if (0 == earliest || sQueue[i]->deadlineMs < earliest) {
+            earliest = sQueue[i]->deadlineMs;
+        }
+    }
+    memset(&spec, 0, sizeof(spec));
+    if (0 != earliest) {
+        spec.it_value.tv_sec  = (time_t)(earliest / 1000);
+        spec.it_value.tv_nsec = (long)(earliest % 1000) * 1000 * 1000;
+    }  // else disarm
+    if (0 != timerfd_settime(sTimerFd, TFD_TIMER_ABSTIME, &spec, NULL)) {
+        Log_Debug("ERROR: failed to arm RTApp request timer: %s (%d).\n",
+            strerror(errno), errno);
+    }
+}
+
+static void
+SendRTApp_WaitOutput(bool waitOutput)
+{
+    if (waitOutput == sWaitOutput) {
+        return;
+    }
+    sWaitOutput = waitOutput;
+    EventLoop_ModifyIoEvents(FieldBusWorker_GetEventLoop(), sSockReg,
+        waitOutput ? (EventLoop_Input | EventLoop_Output) : EventLoop_Input);
+}
+
+// Remove the request from the queue and call its callback
+static void
+SendRTApp_Complete(SendRTAppRequest* req, SendRTAppStatus status,
+    const unsigned char* rxMessage, long rxMessageSize)
+{
+    SendRTAppCallback	callback = req->callback;
+    void*	context = req->context;
+    uint32_t	id = req->id;
+    int	i;
+
+    for (i = 0; i < sQueueLen && sQueue[i] != req; i++) {
+        ;
+    }
+    if (i < sQueueLen) {
+        memmove(&sQueue[i], &sQueue[i + 1],
+            (size_t)(sQueueLen - i - 1) * sizeof(sQueue[0]));
+        sQueueLen--;
+    }
+    if (rxMessageSize > req->rxSize) {
+        rxMessageSize = req->rxSize;
+    }
+    req->id = 0;  // free the slot before calling back, it may submit again
+    callback(id, status, rxMessage, rxMessageSize, context);
+}
+
+static SendRTAppRequest*
+SendRTApp_FindRequest(uint32_t reqId)
+{
+    for (int i = 0; i < sQueueLen; i++) {
+        if (sQueue[i]->id == reqId) {
+            return sQueue[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Send the requests which aren't sent yet (in submission order)
+static void
+SendRTApp_SendPending(void)
+{
+    for (int i = 0; i < sQueueLen; ) {
+        SendRTAppRequest*	req = sQueue[i];
+        ssize_t	bytesSent;
+
+        if (req->isSent) {
+            i++;
+            continue;
+        }
+        bytesSent = send(sSockFd, req->txMessage, (size_t)req->txSize, MSG_DONTWAIT);
+        if (bytesSent == -1) {
+            if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                SendRTApp_WaitOutput(true);
+                return;
+            }
+            Log_Debug("ERROR: Unable to send message: %d (%s)\n", errno, strerror(errno));
+            SendRTApp_Complete(req, SENDRTAPP_ERROR, NULL, 0);
+            continue;
+        }
+        req->isSent = true;
+        i++;
+    }
+    SendRTApp_WaitOutput(false);
+}
+
+// Pass a sample batch to the handler
+static void
+SendRTApp_DispatchSamples(const InterCoreMsgHdr* hdr)
+{
+    const InterCoreSampleBatch*	batch = (const InterCoreSampleBatch*)(hdr + 1);
+    unsigned long	dropped;
+
+    if (hdr->payloadLen < sizeof(InterCoreSampleBatch)
+        || batch->count > INTERCORE_SAMPLE_BATCH_MAX
+        || hdr->payloadLen < sizeof(InterCoreSampleBatch)
+            + batch->count * sizeof(InterCoreSample)) {
+        Log_Debug("WARN: invalid sample batch from RTApp.\n");
+        return;
+    }
+    dropped = batch->dropped;
+    if (sHasSampleSeq && hdr->seq != sNextSampleSeq) {
+        Log_Debug("WARN: lost %u sample batches from RTApp.\n",
+            hdr->seq - sNextSampleSeq);
+        dropped += (unsigned long)(hdr->seq - sNextSampleSeq) * INTERCORE_SAMPLE_BATCH_MAX;
+    }
+    sHasSampleSeq  = true;
+    sNextSampleSeq = hdr->seq + 1;
+    if (NULL != sSampleHandler) {
+        sSampleHandler((const InterCoreSample*)(batch + 1), (int)batch->count,
+            dropped, sSampleContext);
+    }
+}
+
+// Receive the replies
+static void
+SendRTApp_Receive(void)
+{
+    while (true) {
+        ssize_t	bytesReceived = recv(sSockFd, sRxBuf, sizeof(sRxBuf), MSG_DONTWAIT);
+        const InterCoreMsgHdr*	hdr = (const InterCoreMsgHdr*)sRxBuf;
+        SendRTAppRequest*	req;
+
+        if (bytesReceived == -1) {
+            if (EAGAIN != errno && EWOULDBLOCK != errno) {
+                Log_Debug("ERROR: Unable to receive message: %d (%s)\n", errno, strerror(errno));
+            }
+            break;
+        }
+        if (bytesReceived < (ssize_t)sizeof(InterCoreMsgHdr)
+            || hdr->version != INTERCORE_PROTOCOL_VERSION
+            || hdr->payloadLen > bytesReceived - sizeof(InterCoreMsgHdr)) {
+            Log_Debug("WARN: invalid message from RTApp (%d bytes).\n",
+                (int)bytesReceived);
+            continue;
+        }
+        if (hdr->flags & INTERCORE_FLAG_SAMPLES) {
+            SendRTApp_DispatchSamples(hdr);
+            continue;
+        }
+        req = SendRTApp_FindRequest(hdr->seq);
+        if (NULL == req || ! req->isSent) {
+            Log_Debug("WARN: discarded late reply %u from RTApp.\n", hdr->seq);
+            continue;
+        }
+        if (hdr->status != INTERCORE_STATUS_OK) {
+            Log_Debug("WARN: RTApp rejected request %u (status %u).\n",
+                hdr->seq, hdr->status);
+            SendRTApp_Complete(req, SENDRTAPP_REJECTED, NULL, 0);
+        } else {
+            SendRTApp_Complete(req, SENDRTAPP_OK,
+                (const unsigned char*)(hdr + 1), (long)hdr->payloadLen);
+        }
+    }
+    SendRTApp_SendPending();
+    SendRTApp_ArmTimer();
+}
+
+// Fail the requests whose deadline has passed
+static void
+SendRTApp_Expire(uint64_t nowMs)
+{
+    for (int i = 0; i < sQueueLen; ) {
+        SendRTAppRequest*	req = sQueue[i];
+
+        if (req->deadlineMs <= nowMs) {
+            Log_Debug("WARN: RTApp request %u timed out.\n", req->id);
+            SendRTApp_Complete(req, SENDRTAPP_TIMEOUT, NULL, 0);
+        } else {
+            i++;
+        }
+    }
+    SendRTApp_SendPending();
+    SendRTApp_ArmTimer();
+}
+
+static void
+SendRTApp_SockEventHandler(EventLoop* el, int fd,
+    EventLoop_IoEvents events, void* context)
+{
+    FieldBusWorker_Lock();
+    if (events & EventLoop_Output) {
+        SendRTApp_SendPending();
+    }
+    SendRTApp_Receive();
+    FieldBusWorker_Unlock();
+}
+
+static void
+SendRTApp_TimerEventHandler(EventLoop* el, int fd,
+    EventLoop_IoEvents events, void* context)
+{
+    uint64_t	expirations;
+
+    FieldBusWorker_Lock();
+    if (-1 == read(fd, &expirations, sizeof(expirations)) && EAGAIN != errno) {
+        Log_Debug("ERROR: failed to read RTApp request timer: %s (%d).\n",
+            strerror(errno), errno);
+    }
+    SendRTApp_Expire(SendRTApp_GetNowMs());
+    FieldBusWorker_Unlock();
+}
+
+static void
+SendRTApp_SyncCallback(uint32_t reqId, SendRTAppStatus status,
+    const unsigned char* rxMessage, long rxMessageSize, void* context)
+{
+    SendRTAppSyncCtx*	ctx = (SendRTAppSyncCtx*)context;
+
+    if (SENDRTAPP_OK == status) {
+        memcpy(ctx->rxMessage, rxMessage, (size_t)rxMessageSize);
+        ctx->isOk = true;
+    }
+    ctx->isDone = true;
+}
 
 // Initialization and cleanup
 bool
 SendRTApp_InitHandlers(void)
 {
-    // open connection to RTApp and set receive timeout time
-    static const struct timeval recvTimeout =
-        { .tv_sec = 5 * 10,.tv_usec = 0 };
-    int result;
+    // open connection to RTApp, its responses are received by
+    // the field bus thread
+    EventLoop*	eventLoop = FieldBusWorker_GetEventLoop();
 
     sSockFd = Application_Connect(rtAppComponentId);
     if (sSockFd == -1) {
         Log_Debug("ERROR: Unable to create socket: %d (%s)\n", errno, strerror(errno));
         return false;
     }
-    result = setsockopt(sSockFd,
-        SOL_SOCKET, SO_RCVTIMEO, &recvTimeout, sizeof(recvTimeout));
-    if (result == -1) {
-        Log_Debug("ERROR: Unable to set socket timeout: %d (%s)\n", errno, strerror(errno));
-        return false;
+    if (-1 == fcntl(sSockFd, F_SETFL, fcntl(sSockFd, F_GETFL) | O_NONBLOCK)) {
+        Log_Debug("ERROR: Unable to set socket non-blocking: %d (%s)\n", errno, strerror(errno));
+        goto err;
+    }
+    sTimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (sTimerFd == -1) {
+        Log_Debug("ERROR: Unable to create timer: %d (%s)\n", errno, strerror(errno));
+        goto err;
+    }
+    sSockReg = EventLoop_RegisterIo(eventLoop, sSockFd, EventLoop_Input,
+        SendRTApp_SockEventHandler, NULL);
+    sTimerReg = EventLoop_RegisterIo(eventLoop, sTimerFd, EventLoop_Input,
+        SendRTApp_TimerEventHandler, NULL);
+    if (NULL == sSockReg || NULL == sTimerReg) {
+        Log_Debug("ERROR: Unable to register socket: %d (%s)\n", errno, strerror(errno));
+        goto err;
     }
 
     return true;
+
+err:
+    SendRTApp_CloseHandlers();
+    return false;
 }
 
 void SendRTApp_CloseHandlers(void)
 {
+    EventLoop*	eventLoop = FieldBusWorker_GetEventLoop();
+
     Log_Debug("Closing file descriptors.\n");
+    FieldBusWorker_Lock();
+    while (0 < sQueueLen) {
+        SendRTApp_Complete(sQueue[0], SENDRTAPP_ERROR, NULL, 0);
+    }
+    if (NULL != sSockReg) {
+        EventLoop_UnregisterIo(eventLoop, sSockReg);
+        sSockReg = NULL;
+    }
+    if (NULL != sTimerReg) {
+        EventLoop_UnregisterIo(eventLoop, sTimerReg);
+        sTimerReg = NULL;
+    }
     if (sSockFd >= 0) {
         if (close(sSockFd) != 0) {
             Log_Debug("ERROR: Could not close fd %s: %s (%d).\n", "Socket", strerror(errno), errno);
         }
+        sSockFd = -1;
     }
+    if (sTimerFd >= 0) {
+        close(sTimerFd);
+        sTimerFd = -1;
+    }
+    sWaitOutput = false;
+    FieldBusWorker_Unlock();
 }
 
 // Send request message to RTApp (and receve response)
+//  (SendRTApp_SendMessageToRTCore() asks RTApp not to reply)
 bool
 SendRTApp_SendMessageToRTCore(
     const unsigned char* txMessage, long txMessageSize)
 {
-    int bytesSent = send(sSockFd, txMessage, (size_t)txMessageSize, 0);
+    unsigned char	buf[sizeof(InterCoreMsgHdr) + SENDRTAPP_MESSAGE_MAX];
+    InterCoreMsgHdr*	hdr = (InterCoreMsgHdr*)buf;
+    int bytesSent;
 
+    if (txMessageSize > SENDRTAPP_MESSAGE_MAX) {
+        return false;
+    }
+    hdr->version    = INTERCORE_PROTOCOL_VERSION;
+    hdr->flags      = INTERCORE_FLAG_NO_REPLY;
+    hdr->status     = INTERCORE_STATUS_OK;
+    hdr->seq        = 0;
+    hdr->payloadLen = (uint32_t)txMessageSize;
+    memcpy(hdr + 1, txMessage, (size_t)txMessageSize);
+    bytesSent = send(sSockFd, buf, sizeof(InterCoreMsgHdr) + (size_t)txMessageSize, 0);
     if (bytesSent == -1) {
         Log_Debug("ERROR: Unable to send message: %d (%s)\n", errno, strerror(errno));
-        SendRTApp_CloseHandlers();
         return false;
     }
 
@@ -101,17 +431,121 @@ SendRTApp_SendMessageToRTCoreAndReadMessage(
     const unsigned char* txMessage, long txMessageSize,
     unsigned char* rxMessage, long rxMessageSize)
 {
-    int bytesReceived;
+    SendRTAppSyncCtx	ctx = { rxMessage, rxMessageSize, false, false };
+    uint32_t	reqId;
 
-    if (! SendRTApp_SendMessageToRTCore(txMessage, txMessageSize)) {
-        return false;
+    // submit and process the socket events here until the request
+    // completes, the callbacks of the preceding requests are also called
+    FieldBusWorker_Lock();
+    reqId = SendRTApp_SubmitRequest(txMessage, txMessageSize, rxMessageSize,
+        SENDRTAPP_TIMEOUT_MS, SendRTApp_SyncCallback, &ctx);
+    while (0 != reqId && ! ctx.isDone) {
+        struct pollfd	pfd = { .fd = sSockFd, .events = POLLIN, .revents = 0 };
+        uint64_t	nowMs = SendRTApp_GetNowMs();
+        uint64_t	deadlineMs = sQueue[0]->deadlineMs;
+        int	result;
+
+        for (int i = 1; i < sQueueLen; i++) {
+            if (sQueue[i]->deadlineMs < deadlineMs) {
+                deadlineMs = sQueue[i]->deadlineMs;
+            }
+        }
+        if (sWaitOutput) {
+            pfd.events |= POLLOUT;
+        }
+        result = poll(&pfd, 1, (deadlineMs > nowMs) ? (int)(deadlineMs - nowMs) : 0);
+        if (result > 0) {
+            if (pfd.revents & POLLOUT) {
+                SendRTApp_SendPending();
+            }
+            SendRTApp_Receive();
+        } else if (result == 0) {
+            SendRTApp_Expire(SendRTApp_GetNowMs());
+        } else if (errno != EINTR) {
+            Log_Debug("ERROR: Unable to wait message: %d (%s)\n", errno, strerror(errno));
+            SendRTApp_CancelRequest(reqId);
+        }
     }
-    bytesReceived = recv(sSockFd, rxMessage, (size_t)rxMessageSize, 0);
-    if (bytesReceived == -1) {
-        Log_Debug("ERROR: Unable to receive message: %d (%s)\n", errno, strerror(errno));
-        SendRTApp_CloseHandlers();
-        return false;
+    FieldBusWorker_Unlock();
+
+    return ctx.isOk;
+}
+
+// Asynchronous request (returns request ID, 0 on failure)
+uint32_t
+SendRTApp_SubmitRequest(
+    const unsigned char* txMessage, long txMessageSize,
+    long rxMessageSize, unsigned int timeoutMs,
+    SendRTAppCallback callback, void* context)
+{
+    SendRTAppRequest*	req = NULL;
+    InterCoreMsgHdr*	hdr;
+    uint32_t	reqId = 0;
+
+    if (sSockFd < 0 || txMessageSize > SENDRTAPP_MESSAGE_MAX || NULL == callback) {
+        return 0;
+    }
+    FieldBusWorker_Lock();
+    for (int i = 0; i < SENDRTAPP_REQUEST_NUM; i++) {
+        if (0 == sRequests[i].id) {
+            req = &sRequests[i];
+            break;
+        }
     }
+    if (NULL == req) {
+        Log_Debug("ERROR: too many RTApp requests.\n");
+        goto end;
+    }
+    reqId = sNextId++;
+    if (0 == sNextId) {
+        sNextId = 1;
+    }
+    hdr = (InterCoreMsgHdr*)req->txMessage;
+    hdr->version    = INTERCORE_PROTOCOL_VERSION;
+    hdr->flags      = 0;
+    hdr->status     = INTERCORE_STATUS_OK;
+    hdr->seq        = reqId;
+    hdr->payloadLen = (uint32_t)txMessageSize;
+    memcpy(hdr + 1, txMessage, (size_t)txMessageSize);
+    req->id         = reqId;
+    req->isSent     = false;
+    req->deadlineMs = SendRTApp_GetNowMs() + timeoutMs;
+    req->txSize     = (long)sizeof(InterCoreMsgHdr) + txMessageSize;
+    req->rxSize     = rxMessageSize;
+    req->callback   = callback;
+    req->context    = context;
+    sQueue[sQueueLen++] = req;
 
-    return true;
+    SendRTApp_SendPending();
+    SendRTApp_ArmTimer();
+
+end:
+    FieldBusWorker_Unlock();
+    return reqId;
+}
+
+bool
+SendRTApp_CancelRequest(uint32_t reqId)
+{
+    SendRTAppRequest*	req;
+
+    FieldBusWorker_Lock();
+    req = SendRTApp_FindRequest(reqId);
+    if (NULL != req) {
+        // its reply (if sent) will be discarded as unknown sequence
+        SendRTApp_Complete(req, SENDRTAPP_CANCELED, NULL, 0);
+    }
+    FieldBusWorker_Unlock();
+
+    return (NULL != req);
+}
+
+// Sample stream (NULL handler to stop receiving)
+void
+SendRTApp_SetSampleHandler(SendRTAppSampleHandler handler, void* context)
+{
+    FieldBusWorker_Lock();
+    sSampleHandler = handler;
+    sSampleContext = context;
+    FieldBusWorker_Unlock();
 }
@@ -29,6 +29,38 @@
 #include <stdbool.h>
 #endif
 
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+// maximum size of a message to/from RTApp
+#define SENDRTAPP_MESSAGE_MAX	512
+// number of requests which can be outstanding at the same time
+#define SENDRTAPP_REQUEST_NUM	8
+// deadline of the synchronous requests
+#define SENDRTAPP_TIMEOUT_MS	2000
+
+// completion status of a request
+typedef enum {
+    SENDRTAPP_OK,           // response received
+    SENDRTAPP_TIMEOUT,      // no response until the deadline
+    SENDRTAPP_ERROR,        // socket error
+    SENDRTAPP_REJECTED,     // RTApp replied with an error status
+    SENDRTAPP_CANCELED      // canceled by SendRTApp_CancelRequest()
+} SendRTAppStatus;
+
+// completion callback (called on the field bus thread;
+// rxMessage is valid only in the callback)
+typedef void	(*SendRTAppCallback)(uint32_t reqId, SendRTAppStatus status,
+    const unsigned char* rxMessage, long rxMessageSize, void* context);
+
+// handler of the sample stream from RTApp (called on the field bus thread
+// with the records of a batch; dropped is the number of samples lost
+// since the previous call)
+typedef struct InterCoreSample	InterCoreSample;
+typedef void	(*SendRTAppSampleHandler)(const InterCoreSample* samples,
+    int count, unsigned long dropped, void* context);
+
 // Initialization and cleanup
 extern bool SendRTApp_InitHandlers(void);
 extern void SendRTApp_CloseHandlers(void);
@@ -40,4 +72,16 @@ extern bool SendRTApp_SendMessageToRTCoreAndReadMessage(
     const unsigned char* txMessage, long txMessageSize,
     unsigned char* rxMessage, long rxMessageSize);
 
-#endif  // _TELEMETRYITEMS_H_
+// Asynchronous request (returns request ID, 0 on failure;
+// the ID is the sequence number in the intercore message header)
+extern uint32_t	SendRTApp_SubmitRequest(
+    const unsigned char* txMessage, long txMessageSize,
+    long rxMessageSize, unsigned int timeoutMs,
+    SendRTAppCallback callback, void* context);
+extern bool	SendRTApp_CancelRequest(uint32_t reqId);
+
+// Sample stream (NULL handler to stop receiving)
+extern void	SendRTApp_SetSampleHandler(
+    SendRTAppSampleHandler handler, void* context);
+
+#endif  // _SEND_RTAPP_H_
@@ -0,0 +1,103 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "SpscRing.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+
+// SpscRing data members
+struct SpscRing {
+    void**	mSlots;
+    unsigned int	mMask;      // capacity - 1
+    atomic_uint	mHead;          // next index to pop (written by the consumer)
+    atomic_uint	mTail;          // next index to push (written by the producer)
+};
+
+// Initialization and cleanup (capacity: power of 2)
+SpscRing*
+SpscRing_New(unsigned int capacity)
+{
+    SpscRing*	newObj;
+
+    if (0 == capacity || 0 != (capacity & (capacity - 1))) {
+        return NULL;
+    }
+    newObj = (SpscRing*)malloc(sizeof(SpscRing));
+    if (NULL != newObj) {
+        newObj->mSlots = (void**)malloc(sizeof(void*) * capacity);
+        if (NULL == newObj->mSlots) {
+            free(newObj);
+            return NULL;
+        }
+        newObj->mMask = capacity - 1;
+        atomic_init(&newObj->mHead, 0);
+        atomic_init(&newObj->mTail, 0);
+    }
+
+    return newObj;
+}
+
+void
+SpscRing_Destroy(SpscRing* me)
+{
+    free(me->mSlots);
+    free(me);
+}
+
+// Operation by the producer (false: full)
+bool
+SpscRing_Push(SpscRing* me, void* elem)
+{
+    // the slot is published to the consumer by the release of the tail
+    unsigned int	tail = atomic_load_explicit(&me->mTail, memory_order_relaxed);
+    unsigned int	head = atomic_load_explicit(&me->mHead, memory_order_acquire);
+
+    if (tail - head > me->mMask) {
+        return false;
+    }
+    me->mSlots[tail & me->mMask] = elem;
+    atomic_store_explicit(&me->mTail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+// Operation by the consumer (NULL: empty)
+void*
+SpscRing_Pop(SpscRing* me)
+{
+    // the slot is given back to the producer by the release of the head
+    unsigned int	head = atomic_load_explicit(&me->mHead, memory_order_relaxed);
+    unsigned int	tail = atomic_load_explicit(&me->mTail, memory_order_acquire);
+    void*	elem;
+
+    if (head == tail) {
+        return NULL;
+    }
+    elem = me->mSlots[head & me->mMask];
+    atomic_store_explicit(&me->mHead, head + 1, memory_order_release);
+
+    return elem;
+}
@@ -0,0 +1,47 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _SPSC_RING_H_
+#define _SPSC_RING_H_
+
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+
+// Lock-free ring of pointers between one producer thread and one
+// consumer thread
+typedef struct SpscRing	SpscRing;
+
+// Initialization and cleanup (capacity: power of 2)
+extern SpscRing*	SpscRing_New(unsigned int capacity);
+extern void	SpscRing_Destroy(SpscRing* me);
+
+// Operation by the producer (false: full)
+extern bool	SpscRing_Push(SpscRing* me, void* elem);
+
+// Operation by the consumer (NULL: empty)
+extern void*	SpscRing_Pop(SpscRing* me);
+
+#endif  // _SPSC_RING_H_
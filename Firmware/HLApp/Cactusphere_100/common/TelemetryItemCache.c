@@ -26,11 +26,11 @@
 
 #include <limits.h>
 #include <stdlib.h>
-#include <string.h>
 
 #include "TelemetryItems.h"
 
-const char	MARKER_NAME[] = "___-___";
+// item ID of time stamp / separation marker (never used by the names)
+#define MARKER_ID	UINT32_MAX
 
 typedef struct TelemetryItemCache {
     TelemetryCacheElem* mRingBuf;	// ring buffer area
@@ -48,14 +48,14 @@ TelemetryItemCache_DiscardOldestCache(TelemetryItemCache* me)
     const TelemetryCacheElem* cacheElem =
         me->mRingBuf + (me->mReadPos % me->mBufSize);
 
-    if (0 == strcmp(cacheElem->itemName, MARKER_NAME)) {
+    if (MARKER_ID == cacheElem->itemId) {
         if (++(me->mReadPos) > me->mIndexMax) {
             me->mReadPos = 0;
         }
         cacheElem = me->mRingBuf + (me->mReadPos % me->mBufSize);
     }
     while (! TelemetryItemCache_IsEmpty(me)) {
-        if (0 == strcmp(cacheElem->itemName, MARKER_NAME)) {
+        if (MARKER_ID == cacheElem->itemId) {
             break;
         }
         if (++(me->mReadPos) > me->mIndexMax) {
@@ -190,7 +190,7 @@ TelemetryItemCache_EnqueueItems(TelemetryItemCache* me,
     }
 
     curs = me->mRingBuf + (me->mWritePos % me->mBufSize);
-    curs->itemName = MARKER_NAME;
+    curs->itemId   = MARKER_ID;
     curs->value.ul = timeStamp;
     if (++(me->mWritePos) > me->mIndexMax) {
         me->mWritePos = 0;
@@ -224,7 +224,7 @@ TelemetryItemCache_DequeueItemsTo(TelemetryItemCache* me,
     *outTimeStamp = 0;
 
     cacheElem = me->mRingBuf + (me->mReadPos % me->mBufSize);
-    if (0 != strcmp(cacheElem->itemName, MARKER_NAME)) {
+    if (MARKER_ID != cacheElem->itemId) {
         // skip until time stamp / separation marker appears
         do {
             if (++(me->mReadPos) > me->mIndexMax) {
@@ -234,7 +234,7 @@ TelemetryItemCache_DequeueItemsTo(TelemetryItemCache* me,
                 return false;  // reached to end
             }
             cacheElem = me->mRingBuf + (me->mReadPos % me->mBufSize);
-        } while (0 != strcmp(cacheElem->itemName, MARKER_NAME));
+        } while (MARKER_ID != cacheElem->itemId);
     }
     *outTimeStamp = cacheElem->value.ul;
     if (++(me->mReadPos) > me->mIndexMax) {
@@ -243,7 +243,7 @@ TelemetryItemCache_DequeueItemsTo(TelemetryItemCache* me,
 
     while (! TelemetryItemCache_IsEmpty(me)) {
         cacheElem = me->mRingBuf + (me->mReadPos % me->mBufSize);
-        if (0 == strcmp(cacheElem->itemName, MARKER_NAME)) {
+        if (MARKER_ID == cacheElem->itemId) {
             break;
         }
         TelemetryItems_AddFromCacheElem(outItems, cacheElem);
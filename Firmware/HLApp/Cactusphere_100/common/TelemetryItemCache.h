@@ -37,7 +37,7 @@ typedef struct TelemetryItems	TelemetryItems;
 
 // telemetry item data for caching
 typedef struct TelemetryCacheElem {
-    const char* itemName;
+    uint32_t    itemId;     // interned ID of the telemetry item name
     union {
         uint32_t    ul;
         float       f;
@@ -23,39 +23,96 @@
  */
 
 #include <errno.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <applibs/log.h>
 
 #include "dictionary.h"
-#include "json.h"
-#include "vector.h"
 
+#include "FetchItemBase.h"
 #include "TelemetryItems.h"
 #include "TelemetryItemCache.h"
-#include "StringBuf.h"
 
-// string representation of telemetry data item
+#define TELEMETRY_ITEMS_INIT_CAPACITY	16	// initial capacity of items array
+#define JSON_VALUE_MAX_LEN	24	// max length of a formatted value ("-2.2250738585072014e-308")
+
+// kind of aggregate
+enum {
+    AGGR_MIN = 0,
+    AGGR_MAX,
+    AGGR_MEAN,
+    AGGR_LAST,
+    AGGR_COUNT,
+    AGGR_STDDEV,
+    AGGR_NUM
+};
+
+// name suffix of aggregate telemetry item
+static const char* const	sAggrSuffixes[AGGR_NUM] = {
+    "_min", "_max", "_mean", "_last", "_count", "_stddev"
+};
+
+// windowed aggregation state (updated incrementally per sample)
+typedef struct TelemetryAggregation {
+    const TelemetryKey* keys[AGGR_NUM]; // keys of aggregate items
+    uint32_t    windowStart;    // time stamp of the first sample in window
+    uint32_t    count;          // number of samples in window
+    double      min;
+    double      max;
+    double      mean;           // running mean
+    double      m2;             // sum of squared differences from the mean
+    double      last;
+} TelemetryAggregation;
+
+// telemetry item name with its JSON key fragment
+struct TelemetryKey {
+    char*       name;       // telemetry item name
+    uint32_t    id;         // interned ID of the name (index of sTelemetryKeysById)
+    char*       jsonKey;    // escaped JSON key fragment ("name":)
+    size_t      jsonKeyLen; // length of jsonKey
+    TelemetryValueType  valueType;  // value type
+    ReportCondition     reportCond; // reporting condition
+    TelemetryAggregation*   aggr;   // aggregation state (NULL if not aggregated)
+    bool        hasReported;    // whether lastValue and lastReportTime are valid
+    double      lastValue;      // last reported value
+    uint32_t    lastReportTime; // time stamp of last report
+};
+
+// telemetry data item
 typedef struct TelemetryItem {
-    const char* name;
-    char* value;
+    const TelemetryKey* key;
+    TelemetryValueType  type;
+    union {
+        uint32_t    u32;
+        int32_t     i32;
+        float       f;
+        double      d;
+        bool        b;
+    }	value;
 } TelemetryItem;
 
 // TelemetryItems class's data members
 struct TelemetryItems {
-    vector     mBody; // vector of telemetry data item
-    StringBuf* mSb;   // for string processing
+    TelemetryItem*  mItems;     // array of telemetry data item
+    int             mCount;     // number of items in use
+    int             mCapacity;  // allocated number of items
+    size_t          mJsonSizeMax;   // upper limit of JSON text size
 };
 
-// telemetry item data type dictionary element
-typedef struct TelemetryItemDictElem {
-    const char* itemName;	// telemetry item name
-    bool        isFloat;	// whether value type is float
-} TelemetryItemDictElem;
-
-// telemetry item data type dictionary
+// telemetry item data type dictionary (name -> TelemetryKey*),
+// which interns the names when the configuration is loaded
 static dictionary	sTelemetryItemDict = NULL;
+// keys indexed by the interned ID (ID -> TelemetryKey*)
+static vector	sTelemetryKeysById = NULL;
+// guards the dictionaries and the mutable part of the keys (reporting
+// condition, last report and aggregation), which the field bus thread
+// updates on configuration load and the main thread uses on delivery
+// (held only for in-memory work, never across the field bus I/O)
+static pthread_mutex_t	sKeyLock = PTHREAD_MUTEX_INITIALIZER;
 
 // comparator function for the dictionary
 static int
@@ -64,41 +121,364 @@ TelemetryItemDictComparator(const void* const one, const void* const two)
     return strcmp(*((char**)one), *((char**)two));
 }
 
+static TelemetryKey*
+TelemetryKey_New(const char* itemName, TelemetryValueType valueType)
+{
+    // allocate the key with its name and JSON key fragment at once
+    // (each byte of the name is escaped to 6 bytes at most)
+    size_t	nameLen = strlen(itemName);
+    TelemetryKey*	newObj = (TelemetryKey*)malloc(
+        sizeof(TelemetryKey) + (nameLen + 1) + (nameLen * 6 + 4));
+    char*	curs;
+
+    if (NULL == newObj) {
+        return NULL;
+    }
+    newObj->name    = (char*)(newObj + 1);
+    newObj->jsonKey = newObj->name + nameLen + 1;
+    memcpy(newObj->name, itemName, nameLen + 1);
+
+    curs = newObj->jsonKey;
+    *curs++ = '"';
+    for (const unsigned char* p = (const unsigned char*)itemName; *p; ++p) {
+        if ('"' == *p || '\\' == *p) {
+            *curs++ = '\\';
+            *curs++ = (char)*p;
+        } else if (0x20 > *p) {
+            curs += sprintf(curs, "\\u%04x", *p);
+        } else {
+            *curs++ = (char)*p;
+        }
+    }
+    *curs++ = '"';
+    *curs++ = ':';
+    *curs   = '\0';
+    newObj->jsonKeyLen = (size_t)(curs - newObj->jsonKey);
+    newObj->valueType  = valueType;
+    memset(&newObj->reportCond, 0, sizeof(newObj->reportCond));
+    newObj->aggr        = NULL;
+    newObj->hasReported = false;
+
+    return newObj;
+}
+
+static TelemetryItem*
+TelemetryItems_AddItem(TelemetryItems* me, const TelemetryKey* key,
+    TelemetryValueType type)
+{
+    // the array only grows, so that the allocation is done only 
+    // until it reaches the number of items required per a period
+    TelemetryItem*	item;
+
+    if (NULL == key) {
+        return NULL;  // not registered
+    }
+    if (me->mCount == me->mCapacity) {
+        int	newCapacity = me->mCapacity * 2;
+        TelemetryItem*	newItems = (TelemetryItem*)realloc(
+            me->mItems, sizeof(TelemetryItem) * newCapacity);
+
+        if (NULL == newItems) {
+            Log_Debug("ERROR: failed to add telemetry item %s\n", key->name);
+            return NULL;
+        }
+        me->mItems    = newItems;
+        me->mCapacity = newCapacity;
+    }
+    item = me->mItems + me->mCount++;
+    item->key  = key;
+    item->type = type;
+    me->mJsonSizeMax += key->jsonKeyLen + JSON_VALUE_MAX_LEN + 1;
+
+    return item;
+}
+
+static double
+TelemetryItems_GetValueAsDouble(const TelemetryItem* item)
+{
+    switch (item->type) {
+    case TELEMETRY_TYPE_INT32:
+        return (double)item->value.i32;
+    case TELEMETRY_TYPE_FLOAT:
+        return (double)item->value.f;
+    case TELEMETRY_TYPE_DOUBLE:
+        return item->value.d;
+    case TELEMETRY_TYPE_BOOL:
+        return item->value.b ? 1.0 : 0.0;
+    default:
+        return (double)item->value.u32;
+    }
+}
+
+static bool
+TelemetryItems_NeedsReport(TelemetryKey* key, double value, uint32_t timeStamp)
+{
+    // report if the change from the last reported value exceeds 
+    // the deadband, or the max silence interval has elapsed
+    const ReportCondition*	cond = &key->reportCond;
+    double	threshold;
+
+    if (DEADBAND_NONE == cond->deadbandType || ! key->hasReported) {
+        return true;
+    }
+    if (0 != cond->maxSilenceSec
+        && timeStamp - key->lastReportTime >= cond->maxSilenceSec) {
+        return true;
+    }
+
+    threshold = cond->deadband;
+    if (DEADBAND_PERCENT == cond->deadbandType) {
+        threshold = fabs(key->lastValue) * cond->deadband / 100.0;
+    }
+
+    return (fabs(value - key->lastValue) > threshold);
+}
+
+static void
+TelemetryItems_Compact(TelemetryItems* me)
+{
+    // remove the items marked as removed (whose key is NULL)
+    TelemetryItem*	dst = me->mItems;
+
+    me->mJsonSizeMax = sizeof("{}");
+    for (int i = 0, n = me->mCount; i < n; i++) {
+        const TelemetryItem*	item = me->mItems + i;
+
+        if (NULL == item->key) {
+            continue;
+        }
+        *dst++ = *item;
+        me->mJsonSizeMax += item->key->jsonKeyLen + JSON_VALUE_MAX_LEN + 1;
+    }
+    me->mCount = (int)(dst - me->mItems);
+}
+
+static void
+TelemetryItems_AddAggregates(TelemetryItems* me, const TelemetryKey* key)
+{
+    // add aggregates of the window, then reset the window
+    TelemetryAggregation*	aggr = key->aggr;
+
+    TelemetryItems_AddDouble(me, aggr->keys[AGGR_MIN], aggr->min);
+    TelemetryItems_AddDouble(me, aggr->keys[AGGR_MAX], aggr->max);
+    TelemetryItems_AddDouble(me, aggr->keys[AGGR_MEAN], aggr->mean);
+    TelemetryItems_AddDouble(me, aggr->keys[AGGR_LAST], aggr->last);
+    TelemetryItems_AddUInt32(me, aggr->keys[AGGR_COUNT], aggr->count);
+    if (key->reportCond.aggregateStddev) {
+        TelemetryItems_AddDouble(me, aggr->keys[AGGR_STDDEV],
+            sqrt(aggr->m2 / aggr->count));
+    }
+    aggr->count = 0;
+}
+
+static void
+TelemetryAggregation_AddSample(TelemetryAggregation* aggr,
+    double value, uint32_t timeStamp)
+{
+    // update min/max/mean and the sum of squared differences 
+    // by Welford's method
+    double	delta;
+
+    if (0 == aggr->count) {
+        aggr->windowStart = timeStamp;
+        aggr->min  = aggr->max = value;
+        aggr->mean = aggr->m2  = 0.0;
+    } else if (value < aggr->min) {
+        aggr->min = value;
+    } else if (value > aggr->max) {
+        aggr->max = value;
+    }
+    aggr->count++;
+    delta       = value - aggr->mean;
+    aggr->mean += delta / aggr->count;
+    aggr->m2   += delta * (value - aggr->mean);
+    aggr->last  = value;
+}
+
+static char*
+TelemetryItems_WriteUInt(char* dst, uint32_t value)
+{
+    char	digits[10];
+    int 	n = 0;
+
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (0 != value);
+    while (0 < n) {
+        *dst++ = digits[--n];
+    }
+
+    return dst;
+}
+
+static char*
+TelemetryItems_WriteInt(char* dst, int32_t value)
+{
+    if (0 > value) {
+        *dst++ = '-';
+        return TelemetryItems_WriteUInt(dst, 0u - (uint32_t)value);
+    }
+
+    return TelemetryItems_WriteUInt(dst, (uint32_t)value);
+}
+
+static char*
+TelemetryItems_WriteReal(char* dst, double value, bool isFloat)
+{
+    // Write integral values directly, otherwise write the shortest 
+    // representation which reads back to the same value. The shortest 
+    // one is found by increasing the precision from the one which 
+    // is always exact for decimal values (6 digits for float, 15 for double).
+    char	tmp[32];
+    int 	len = 0;
+
+    if (! isfinite(value)) {
+        memcpy(dst, "null", 4);  // not representable in JSON
+        return dst + 4;
+    }
+    if (-2147483648.0 <= value && value < 2147483648.0
+        && value == (double)(int32_t)value) {
+        return TelemetryItems_WriteInt(dst, (int32_t)value);
+    }
+
+    if (isFloat) {
+        for (int prec = 6; prec <= 9; ++prec) {
+            len = snprintf(tmp, sizeof(tmp), "%.*g", prec, value);
+            if (strtof(tmp, NULL) == (float)value) {
+                break;
+            }
+        }
+    } else {
+        for (int prec = 15; prec <= 17; ++prec) {
+            len = snprintf(tmp, sizeof(tmp), "%.*g", prec, value);
+            if (strtod(tmp, NULL) == value) {
+                break;
+            }
+        }
+    }
+    memcpy(dst, tmp, (size_t)len);
+
+    return dst + len;
+}
+
 // Initialization and cleanup of the telemetry item data type dicitionary
 void
 TelemetryItems_InitDictionary(void)
 {
+    pthread_mutex_lock(&sKeyLock);
     if (NULL == sTelemetryItemDict) {
         sTelemetryItemDict = dictionary_init(
-            sizeof(char*), sizeof(TelemetryItemDictElem),
-            TelemetryItemDictComparator);
+            sizeof(char*), sizeof(TelemetryKey*),
+            TelemetryItemDictComparator, dictionary_hash_string);
     }
+    if (NULL == sTelemetryKeysById) {
+        sTelemetryKeysById = vector_init(sizeof(TelemetryKey*));
+    }
+    pthread_mutex_unlock(&sKeyLock);
 }
 
 void
 TelemetryItems_CleanupDictionary(void)
 {
+    pthread_mutex_lock(&sKeyLock);
+    if (NULL != sTelemetryKeysById) {
+        TelemetryKey**	curs = (TelemetryKey**)vector_get_data(sTelemetryKeysById);
+
+        for (int i = 0, n = vector_size(sTelemetryKeysById); i < n; ++i) {
+            free(curs[i]->aggr);
+            free(curs[i]);
+        }
+        vector_destroy(sTelemetryKeysById);
+        sTelemetryKeysById = NULL;
+    }
     if (NULL != sTelemetryItemDict) {
         dictionary_destroy(sTelemetryItemDict);
         sTelemetryItemDict = NULL;
     }
+    pthread_mutex_unlock(&sKeyLock);
 }
 
-// Add and remove telemetry item data type
-void
-TelemetryItems_AddDictionaryElem(const char* itemName, bool isFloat)
+static const TelemetryKey*
+TelemetryItems_AddKey(const char* itemName, TelemetryValueType valueType)
 {
-    TelemetryItemDictElem	pseudo;
+    // keys are never removed, because cached data items refer them 
+    // even after the configuration has changed
+    // (called with sKeyLock locked)
+    TelemetryKey*	key;
+
+    if (dictionary_get(&key, sTelemetryItemDict, &itemName)) {
+        key->valueType = valueType;
+        return key;
+    }
+    key = TelemetryKey_New(itemName, valueType);
+    if (NULL != key) {
+        key->id = (uint32_t)vector_size(sTelemetryKeysById);
+        if (0 != vector_add_last(sTelemetryKeysById, &key)) {
+            free(key);
+            return NULL;
+        }
+        if (0 != dictionary_put(sTelemetryItemDict, &key->name, &key)) {
+            vector_remove_last(sTelemetryKeysById);
+            free(key);
+            return NULL;
+        }
+    }
 
-    pseudo.itemName = itemName;
-    pseudo.isFloat  = isFloat;
-    dictionary_put(sTelemetryItemDict, &itemName, &pseudo);
+    return key;
 }
 
+// Add telemetry item data type and get the key to add data items
+const TelemetryKey*
+TelemetryItems_AddDictionaryElem(const char* itemName,
+    TelemetryValueType valueType)
+{
+    const TelemetryKey*	key;
+
+    pthread_mutex_lock(&sKeyLock);
+    key = TelemetryItems_AddKey(itemName, valueType);
+    pthread_mutex_unlock(&sKeyLock);
+
+    return key;
+}
+
+// Set reporting condition of telemetry item
 void
-TelemetryItems_RemoveDictionaryElem(const char* itemName)
+TelemetryItems_SetReportCondition(const TelemetryKey* key,
+    const ReportCondition* cond)
 {
-    dictionary_remove(sTelemetryItemDict, &itemName);
+    // (the key is owned by the dictionary, so it can be modified here)
+    TelemetryKey*	self = (TelemetryKey*)key;
+
+    if (NULL == self) {
+        return;
+    }
+    pthread_mutex_lock(&sKeyLock);
+    self->reportCond  = *cond;
+    self->hasReported = false;
+
+    if (0 == cond->aggregateWindowSec) {
+        free(self->aggr);
+        self->aggr = NULL;
+        goto unlock;
+    }
+    if (NULL == self->aggr) {
+        char	nameBuf[TELEMETRY_NAME_MAX_LEN + 16];
+
+        self->aggr = (TelemetryAggregation*)malloc(sizeof(TelemetryAggregation));
+        if (NULL == self->aggr) {
+            Log_Debug("ERROR: failed to setup aggregation of %s\n", self->name);
+            goto unlock;
+        }
+        for (int i = 0; i < AGGR_NUM; i++) {
+            snprintf(nameBuf, sizeof(nameBuf), "%s%s", self->name, sAggrSuffixes[i]);
+            self->aggr->keys[i] = TelemetryItems_AddKey(nameBuf,
+                AGGR_COUNT == i ? TELEMETRY_TYPE_UINT32 : TELEMETRY_TYPE_DOUBLE);
+        }
+    }
+    self->aggr->count = 0;
+unlock:
+    pthread_mutex_unlock(&sKeyLock);
 }
 
 // Initialization and cleanup
@@ -108,18 +488,14 @@ TelemetryItems_New(void)
     TelemetryItems* newObj = (TelemetryItems*)malloc(sizeof(TelemetryItems));
 
     if (newObj != NULL) {
-        newObj->mBody = vector_init(sizeof(TelemetryItem));
-        newObj->mSb   = StringBuf_New();
-        if (newObj->mBody == NULL || newObj->mSb == NULL) {
-            if (newObj->mBody != NULL) {
-                vector_destroy(newObj->mBody);
-            }
-            if (newObj->mSb != NULL) {
-                StringBuf_Destroy(newObj->mSb);
-            }
+        newObj->mItems = (TelemetryItem*)malloc(
+            sizeof(TelemetryItem) * TELEMETRY_ITEMS_INIT_CAPACITY);
+        if (newObj->mItems == NULL) {
             free(newObj);
-            newObj = NULL;
+            return NULL;
         }
+        newObj->mCapacity = TELEMETRY_ITEMS_INIT_CAPACITY;
+        TelemetryItems_Clear(newObj);
     }
 
     return newObj;
@@ -129,9 +505,7 @@ void
 TelemetryItems_Destroy(TelemetryItems* me)
 {
     if (me != NULL) {
-        TelemetryItems_Clear(me);
-        vector_destroy(me->mBody);
-        StringBuf_Destroy(me->mSb);
+        free(me->mItems);
         free(me);
     }
 }
@@ -140,29 +514,149 @@ TelemetryItems_Destroy(TelemetryItems* me)
 int
 TelemetryItems_Count(const TelemetryItems* me)
 {
-    return vector_size(me->mBody);
+    return me->mCount;
 }
 
 // Add and remove telemetry data item
 void
-TelemetryItems_Add(TelemetryItems* me, const char* name, const char* value)
+TelemetryItems_AddUInt32(TelemetryItems* me, const TelemetryKey* key,
+    uint32_t value)
+{
+    TelemetryItem*	item = TelemetryItems_AddItem(me, key, TELEMETRY_TYPE_UINT32);
+
+    if (NULL != item) {
+        item->value.u32 = value;
+    }
+}
+
+void
+TelemetryItems_AddInt32(TelemetryItems* me, const TelemetryKey* key,
+    int32_t value)
 {
-    TelemetryItem telemetryItem;
-    char* newValue = strdup(value);
+    TelemetryItem*	item = TelemetryItems_AddItem(me, key, TELEMETRY_TYPE_INT32);
 
-    telemetryItem.name  = name;
-    telemetryItem.value = newValue;
-    vector_add_last(me->mBody, &telemetryItem);
+    if (NULL != item) {
+        item->value.i32 = value;
+    }
+}
+
+void
+TelemetryItems_AddFloat(TelemetryItems* me, const TelemetryKey* key,
+    float value)
+{
+    TelemetryItem*	item = TelemetryItems_AddItem(me, key, TELEMETRY_TYPE_FLOAT);
+
+    if (NULL != item) {
+        item->value.f = value;
+    }
+}
+
+void
+TelemetryItems_AddDouble(TelemetryItems* me, const TelemetryKey* key,
+    double value)
+{
+    TelemetryItem*	item = TelemetryItems_AddItem(me, key, TELEMETRY_TYPE_DOUBLE);
+
+    if (NULL != item) {
+        item->value.d = value;
+    }
+}
+
+void
+TelemetryItems_AddBool(TelemetryItems* me, const TelemetryKey* key,
+    bool value)
+{
+    TelemetryItem*	item = TelemetryItems_AddItem(me, key, TELEMETRY_TYPE_BOOL);
+
+    if (NULL != item) {
+        item->value.b = value;
+    }
+}
+
+void
+TelemetryItems_CopyFrom(TelemetryItems* me, const TelemetryItems* src)
+{
+    if (me->mCapacity < src->mCount) {
+        TelemetryItem*	newItems = (TelemetryItem*)realloc(
+            me->mItems, sizeof(TelemetryItem) * src->mCapacity);
+
+        if (NULL == newItems) {
+            Log_Debug("ERROR: failed to copy telemetry items\n");
+            TelemetryItems_Clear(me);
+            return;
+        }
+        me->mItems    = newItems;
+        me->mCapacity = src->mCapacity;
+    }
+    memcpy(me->mItems, src->mItems, sizeof(TelemetryItem) * src->mCount);
+    me->mCount       = src->mCount;
+    me->mJsonSizeMax = src->mJsonSizeMax;
 }
 
 void
 TelemetryItems_Clear(TelemetryItems* me) {
-    TelemetryItem* tempP = (TelemetryItem*)vector_get_data(me->mBody);
+    me->mCount       = 0;
+    me->mJsonSizeMax = sizeof("{}");
+}
 
-    for (int i = 0, n = vector_size(me->mBody); i < n; i++) {
-        free(tempP[i].value);
+// Remove data items which don't satisfy report-by-exception condition
+void
+TelemetryItems_RemoveUnchanged(TelemetryItems* me, uint32_t timeStamp)
+{
+    bool	removed = false;
+
+    pthread_mutex_lock(&sKeyLock);
+    for (int i = 0, n = me->mCount; i < n; i++) {
+        TelemetryItem*	item = me->mItems + i;
+        TelemetryKey*	key = (TelemetryKey*)item->key;
+        double	value = TelemetryItems_GetValueAsDouble(item);
+
+        if (! TelemetryItems_NeedsReport(key, value, timeStamp)) {
+            item->key = NULL;  // suppress
+            removed   = true;
+            continue;
+        }
+        key->hasReported    = true;
+        key->lastValue      = value;
+        key->lastReportTime = timeStamp;
+    }
+    pthread_mutex_unlock(&sKeyLock);
+    if (removed) {
+        TelemetryItems_Compact(me);
+    }
+}
+
+// Replace samples of aggregated items with aggregates of the window
+void
+TelemetryItems_Aggregate(TelemetryItems* me, uint32_t timeStamp)
+{
+    // Each sample is accumulated into its window. When the window has 
+    // elapsed, the aggregates are added to the end before the sample 
+    // starts the next window.
+    bool	removed = false;
+
+    pthread_mutex_lock(&sKeyLock);
+    for (int i = 0, n = me->mCount; i < n; i++) {
+        const TelemetryKey*	key = me->mItems[i].key;
+        TelemetryAggregation*	aggr = key->aggr;
+        double	value;
+
+        if (NULL == aggr) {
+            continue;
+        }
+        value = TelemetryItems_GetValueAsDouble(me->mItems + i);
+        if (0 < aggr->count
+            && timeStamp - aggr->windowStart >= key->reportCond.aggregateWindowSec) {
+            TelemetryItems_AddAggregates(me, key);  // (me->mItems may move)
+        }
+        TelemetryAggregation_AddSample(aggr, value, timeStamp);
+        me->mItems[i].key = NULL;
+        removed = true;
+    }
+    pthread_mutex_unlock(&sKeyLock);
+    if (removed) {
+        TelemetryItems_Compact(me);
     }
-    vector_clear(me->mBody);
 }
 
 // Mutual conversion between cache elem
@@ -170,20 +664,26 @@ TelemetryCacheElem*
 TelemetryItems_ConvToCacheElemAt(
     const TelemetryItems* me, int index, TelemetryCacheElem* outCacheElem)
 {
-    // Search telemetry item data type dictionary and convert from 
-    // string to number according to data type
-    TelemetryItem*	item = (TelemetryItem*)vector_get_data(me->mBody) + index;
-    TelemetryItemDictElem	dictElem;
-
-    if (! dictionary_get(&dictElem, sTelemetryItemDict, &item->name)) {
-        return NULL;
-    }
-
-    outCacheElem->itemName = item->name;
-    if (dictElem.isFloat) {
-        outCacheElem->value.f = (float)atof(item->value);
-    } else {
-        outCacheElem->value.ul = strtoul(item->value, NULL, 10);
+    // cache elem holds a 32-bit value, so double is narrowed to float
+    const TelemetryItem*	item = me->mItems + index;
+
+    outCacheElem->itemId = item->key->id;
+    switch (item->type) {
+    case TELEMETRY_TYPE_INT32:
+        outCacheElem->value.ul = (uint32_t)item->value.i32;
+        break;
+    case TELEMETRY_TYPE_FLOAT:
+        outCacheElem->value.f = item->value.f;
+        break;
+    case TELEMETRY_TYPE_DOUBLE:
+        outCacheElem->value.f = (float)item->value.d;
+        break;
+    case TELEMETRY_TYPE_BOOL:
+        outCacheElem->value.ul = item->value.b ? 1 : 0;
+        break;
+    default:
+        outCacheElem->value.ul = item->value.u32;
+        break;
     }
 
     return outCacheElem;
@@ -193,84 +693,92 @@ void
 TelemetryItems_AddFromCacheElem(TelemetryItems* me,
     const TelemetryCacheElem* cacheElem)
 {
-    // Search telemetry item data type dictionary and convert from 
-    // number to string according to data type, then add to self
-    TelemetryItemDictElem	dictElem;
-
-    if (! dictionary_get(&dictElem, sTelemetryItemDict,
-            &((TelemetryCacheElem*)cacheElem)->itemName)) {
+    // Look up the key by the interned ID and
+    // add the value to self according to data type
+    const TelemetryKey*	key = NULL;
+    TelemetryValueType	valueType;
+
+    pthread_mutex_lock(&sKeyLock);
+    if (cacheElem->itemId < (uint32_t)vector_size(sTelemetryKeysById)) {
+        key = ((TelemetryKey**)vector_get_data(sTelemetryKeysById))[cacheElem->itemId];
+        valueType = key->valueType;
+    }
+    pthread_mutex_unlock(&sKeyLock);
+    if (NULL == key) {
         return;  // not found; error
     }
 
-    StringBuf_Clear(me->mSb);
-    if (dictElem.isFloat) {
-        StringBuf_AppendByPrintf(me->mSb, "%f", cacheElem->value.f);
-    } else {
-        StringBuf_AppendByPrintf(me->mSb, "%lu", cacheElem->value.ul);
+    switch (valueType) {
+    case TELEMETRY_TYPE_INT32:
+        TelemetryItems_AddInt32(me, key, (int32_t)cacheElem->value.ul);
+        break;
+    case TELEMETRY_TYPE_FLOAT:
+    case TELEMETRY_TYPE_DOUBLE:
+        TelemetryItems_AddFloat(me, key, cacheElem->value.f);
+        break;
+    case TELEMETRY_TYPE_BOOL:
+        TelemetryItems_AddBool(me, key, 0 != cacheElem->value.ul);
+        break;
+    default:
+        TelemetryItems_AddUInt32(me, key, cacheElem->value.ul);
+        break;
     }
-    TelemetryItems_Add(me, cacheElem->itemName, StringBuf_GetStr(me->mSb));
 }
 
 // Convert to JSON text
-const char*
-TelemetryItems_ToJson(TelemetryItems* me)
+size_t
+TelemetryItems_GetJsonSizeMax(const TelemetryItems* me)
 {
-    StringBuf_Clear(me->mSb);
-    StringBuf_AppendChar(me->mSb, '{');
-    for (int i = 0, n = vector_size(me->mBody); i < n; i++) {
-        TelemetryItem tmp;
-        vector_get_at(&tmp, me->mBody, i);
-        StringBuf_AppendByPrintf(me->mSb, "\"%s\":%s", tmp.name, tmp.value);
-        if (n - 1 > i) {
-            StringBuf_AppendChar(me->mSb, ',');
-        }
-    }
-    StringBuf_AppendChar(me->mSb, '}');
-
-    return StringBuf_GetStr(me->mSb);
+    return me->mJsonSizeMax;
 }
 
-// Convert from JSON text
-bool
-TelemetryItems_LoadFromJson(TelemetryItems* me, const char* jsonStr)
+int
+TelemetryItems_ToJson(const TelemetryItems* me, char* buf, size_t bufSize)
 {
-    json_value* jsonObj = json_parse(jsonStr, strlen(jsonStr));
+    // Write JSON text directly into the passed buffer. 
+    // Returns the length of the text, or -1 if the buffer is too small 
+    // (it requires TelemetryItems_GetJsonSizeMax() bytes).
+    char*	curs = buf;
 
-    if (NULL == jsonObj) {
-        return false;
-    } else if (json_object != jsonObj->type) {
-        json_value_free(jsonObj);
-        return false;
-    } else {
-        json_object_entry*  curs = jsonObj->u.object.values;
-        json_object_entry*  end  = curs + jsonObj->u.object.length;
-        TelemetryItemDictElem   dictElem;
-
-        TelemetryItems_Clear(me);
-        for (; curs < end; ++curs) {
-            if (! dictionary_get(&dictElem, sTelemetryItemDict, &curs->name)) {
-                goto err;  // unkown item
-            }
+    if (bufSize < me->mJsonSizeMax) {
+        return -1;
+    }
+    *curs++ = '{';
+    for (int i = 0, n = me->mCount; i < n; i++) {
+        const TelemetryItem*	item = me->mItems + i;
 
-            StringBuf_Clear(me->mSb);
-            switch (curs->value->type) {
-            case json_integer:
-                StringBuf_AppendByPrintf(
-                    me->mSb, "%lu", (uint32_t)curs->value->u.integer);
-                break;
-            case json_double:
-                StringBuf_AppendByPrintf(
-                    me->mSb, "%f", (float)curs->value->u.dbl);
-                break;
-            default:
-                goto err;  // unexpected type
+        if (0 < i) {
+            *curs++ = ',';
+        }
+        memcpy(curs, item->key->jsonKey, item->key->jsonKeyLen);
+        curs += item->key->jsonKeyLen;
+
+        switch (item->type) {
+        case TELEMETRY_TYPE_INT32:
+            curs = TelemetryItems_WriteInt(curs, item->value.i32);
+            break;
+        case TELEMETRY_TYPE_FLOAT:
+            curs = TelemetryItems_WriteReal(curs, item->value.f, true);
+            break;
+        case TELEMETRY_TYPE_DOUBLE:
+            curs = TelemetryItems_WriteReal(curs, item->value.d, false);
+            break;
+        case TELEMETRY_TYPE_BOOL:
+            if (item->value.b) {
+                memcpy(curs, "true", 4);
+                curs += 4;
+            } else {
+                memcpy(curs, "false", 5);
+                curs += 5;
             }
-            TelemetryItems_Add(me, dictElem.itemName, StringBuf_GetStr(me->mSb));
+            break;
+        default:
+            curs = TelemetryItems_WriteUInt(curs, item->value.u32);
+            break;
         }
-
-        return true;
-err:
-        json_value_free(jsonObj);
-        return false;
     }
+    *curs++ = '}';
+    *curs   = '\0';
+
+    return (int)(curs - buf);
 }
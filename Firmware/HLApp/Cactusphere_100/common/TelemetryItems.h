@@ -28,18 +28,39 @@
 #ifndef _STDBOOL
 #include <stdbool.h>
 #endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+#include <stddef.h>
 
 typedef struct TelemetryItems	TelemetryItems;
+typedef struct TelemetryKey	TelemetryKey;
+typedef struct ReportCondition	ReportCondition;
 typedef struct TelemetryCacheElem	TelemetryCacheElem;
 
+// value type of telemetry data item
+typedef enum TelemetryValueType {
+    TELEMETRY_TYPE_UINT32 = 0,
+    TELEMETRY_TYPE_INT32,
+    TELEMETRY_TYPE_FLOAT,
+    TELEMETRY_TYPE_DOUBLE,
+    TELEMETRY_TYPE_BOOL
+} TelemetryValueType;
+
 // Initialization and cleanup of the telemetry item data type dicitionary
 extern void	TelemetryItems_InitDictionary(void);
 extern void	TelemetryItems_CleanupDictionary(void);
 
-// Add and remove telemetry item data type
-extern void	TelemetryItems_AddDictionaryElem(
-    const char* itemName, bool isFloat);
-extern void	TelemetryItems_RemoveDictionaryElem(const char* itemName);
+// Add telemetry item data type and get the key to add data items.
+// The key stays valid until the dictionary is cleaned up.
+// (the keys are guarded by a lock internally, so the field bus thread can
+//  load the configuration while the main thread delivers the telemetry)
+extern const TelemetryKey*	TelemetryItems_AddDictionaryElem(
+    const char* itemName, TelemetryValueType valueType);
+
+// Set reporting condition of telemetry item
+extern void	TelemetryItems_SetReportCondition(
+    const TelemetryKey* key, const ReportCondition* cond);
 
 // Initialization and cleanup
 extern TelemetryItems* TelemetryItems_New(void);
@@ -49,10 +70,28 @@ extern void TelemetryItems_Destroy(TelemetryItems* me);
 extern int	TelemetryItems_Count(const TelemetryItems* me);
 
 // Add and remove telemetry data item
-extern void TelemetryItems_Add(
-    TelemetryItems* me, const char* name, const char* value);
+extern void TelemetryItems_AddUInt32(
+    TelemetryItems* me, const TelemetryKey* key, uint32_t value);
+extern void TelemetryItems_AddInt32(
+    TelemetryItems* me, const TelemetryKey* key, int32_t value);
+extern void TelemetryItems_AddFloat(
+    TelemetryItems* me, const TelemetryKey* key, float value);
+extern void TelemetryItems_AddDouble(
+    TelemetryItems* me, const TelemetryKey* key, double value);
+extern void TelemetryItems_AddBool(
+    TelemetryItems* me, const TelemetryKey* key, bool value);
+extern void TelemetryItems_CopyFrom(
+    TelemetryItems* me, const TelemetryItems* src);
 extern void TelemetryItems_Clear(TelemetryItems* me);
 
+// Remove data items which don't satisfy report-by-exception condition
+extern void TelemetryItems_RemoveUnchanged(
+    TelemetryItems* me, uint32_t timeStamp);
+
+// Replace samples of aggregated items with aggregates of the window
+extern void TelemetryItems_Aggregate(
+    TelemetryItems* me, uint32_t timeStamp);
+
 // Mutual conversion between cache elem
 extern TelemetryCacheElem* TelemetryItems_ConvToCacheElemAt(
     const TelemetryItems* me, int index, TelemetryCacheElem* outCacheElem);
@@ -60,10 +99,8 @@ extern void	TelemetryItems_AddFromCacheElem(TelemetryItems* me,
     const TelemetryCacheElem* cacheElem);
 
 // Convert to JSON text
-extern const char* TelemetryItems_ToJson(TelemetryItems* me);
-
-// Convert from JSON text
-extern bool TelemetryItems_LoadFromJson(
-    TelemetryItems* me, const char* jsonStr);
+extern size_t	TelemetryItems_GetJsonSizeMax(const TelemetryItems* me);
+extern int	TelemetryItems_ToJson(
+    const TelemetryItems* me, char* buf, size_t bufSize);
 
 #endif  // _TELEMETRYITEMS_H_
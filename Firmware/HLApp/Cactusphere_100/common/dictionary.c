@@ -24,43 +24,161 @@
 
 #include "dictionary.h"
 
-#include "map.h"
+#include <errno.h>
+#include <string.h>
+
+#define INIT_SLOT_NUM	16  // initial number of the hash slots (power of 2)
+
+// hash slot, which refers an entry in the key/value arrays
+typedef struct dictionary_slot {
+    unsigned int	hash;   // hash of the key
+    int	index;  // index of the entry + 1 (0: empty slot)
+} dictionary_slot;
 
 struct internal_dictionary {
-    map	body;
-    vector	keys;
+    vector	keys;      // keys in the order of addition
+    vector	values;    // values of the keys
+    dictionary_slot*	slots;
+    int	slot_num;  // number of the slots (power of 2)
     size_t	key_size;
+    size_t	value_size;
     int(*comparator)(const void *const one, const void *const two);
+    unsigned int(*hash)(const void *const key);
 };
 
+static const void*
+dictionary_key_at(dictionary me, int index)
+{
+    return (const char*)vector_get_data(me->keys) + (size_t)index * me->key_size;
+}
+
+// Find the slot of the key, or the empty slot to add it
+static int
+dictionary_find_slot(dictionary me, const void *key, unsigned int hash)
+{
+    int	mask = me->slot_num - 1;
+    int	i    = (int)(hash & (unsigned int)mask);
+
+    while (0 != me->slots[i].index) {
+        if (me->slots[i].hash == hash &&
+            0 == me->comparator(key, dictionary_key_at(me, me->slots[i].index - 1))) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+// Double the slots and place the entries again
+static int
+dictionary_grow(dictionary me)
+{
+    int	newNum = me->slot_num * 2;
+    int	mask   = newNum - 1;
+    dictionary_slot*	newSlots = (dictionary_slot*)calloc(
+        (size_t)newNum, sizeof(dictionary_slot));
+
+    if (NULL == newSlots) {
+        return -ENOMEM;
+    }
+    for (int i = 0; i < me->slot_num; ++i) {
+        if (0 != me->slots[i].index) {
+            int	j = (int)(me->slots[i].hash & (unsigned int)mask);
+
+            while (0 != newSlots[j].index) {
+                j = (j + 1) & mask;
+            }
+            newSlots[j] = me->slots[i];
+        }
+    }
+    free(me->slots);
+    me->slots    = newSlots;
+    me->slot_num = newNum;
+
+    return 0;
+}
+
+// Empty the slot, shifting back the following ones of the same cluster
+static void
+dictionary_clear_slot(dictionary me, int i)
+{
+    int	mask = me->slot_num - 1;
+    int	j    = i;
+
+    for (;;) {
+        int	home;
+
+        j = (j + 1) & mask;
+        if (0 == me->slots[j].index) {
+            break;
+        }
+        home = (int)(me->slots[j].hash & (unsigned int)mask);
+        // move it if its home position isn't in (i, j] cyclically
+        if ((i < j) ? (home <= i || j < home) : (home <= i && j < home)) {
+            me->slots[i] = me->slots[j];
+            i = j;
+        }
+    }
+    me->slots[i].index = 0;
+}
+
 /* Starting */
 dictionary
 dictionary_init(size_t key_size,
     size_t value_size,
-    int(*comparator)(const void *const one, const void *const two))
+    int(*comparator)(const void *const one, const void *const two),
+    unsigned int(*hash)(const void *const key))
 {
     dictionary	newObj = (dictionary)malloc(
         sizeof(struct internal_dictionary));
 
     if (NULL != newObj) {
-        newObj->body = map_init(key_size, value_size, comparator);
-        if (NULL == newObj) {
-            free(newObj);
-            return NULL;
-        }
-        newObj->keys = vector_init(key_size);
-        if (NULL == newObj->keys) {
-            map_destroy(newObj->body);
+        newObj->keys   = vector_init(key_size);
+        newObj->values = vector_init(value_size);
+        newObj->slots  = (dictionary_slot*)calloc(
+            INIT_SLOT_NUM, sizeof(dictionary_slot));
+        if (NULL == newObj->keys || NULL == newObj->values
+            || NULL == newObj->slots) {
+            if (NULL != newObj->keys) {
+                vector_destroy(newObj->keys);
+            }
+            if (NULL != newObj->values) {
+                vector_destroy(newObj->values);
+            }
+            free(newObj->slots);
             free(newObj);
             return NULL;
         }
-        newObj->comparator = comparator;
+        newObj->slot_num   = INIT_SLOT_NUM;
         newObj->key_size   = key_size;
+        newObj->value_size = value_size;
+        newObj->comparator = comparator;
+        newObj->hash       = hash;
     }
 
     return newObj;
 }
 
+/* Hash functions (FNV-1a) */
+unsigned int
+dictionary_hash_chars(const void *const key)
+{
+    unsigned int	hash = 2166136261u;
+
+    for (const unsigned char* curs = (const unsigned char*)key; *curs; ++curs) {
+        hash = (hash ^ *curs) * 16777619u;
+    }
+
+    return hash;
+}
+
+unsigned int
+dictionary_hash_string(const void *const key)
+{
+    return dictionary_hash_chars(*(const char *const *)key);
+}
+
 /* Capacity */
 int
 dictionary_size(dictionary me)
@@ -71,55 +189,95 @@ dictionary_size(dictionary me)
 int
 dictionary_is_empty(dictionary me)
 {
-    return (0 == vector_is_empty(me->keys));
+    return vector_is_empty(me->keys);
 }
 
 /* Accessing */
 int
 dictionary_put(dictionary me, void *key, void *value)
 {
-    if (map_contains(me->body, key)) {
-        return map_put(me->body, key, value);
-    } else {
-        int	retVal = map_put(me->body, key, value);
+    unsigned int	hash = me->hash(key);
+    int	i = dictionary_find_slot(me, key, hash);
+    int	retVal;
+
+    if (0 != me->slots[i].index) {
+        return vector_set_at(me->values, me->slots[i].index - 1, value);
+    }
 
-        if (0 == retVal) {
-            vector_add_last(me->keys, key);
+    // keep the load factor 3/4 or less
+    if ((vector_size(me->keys) + 1) * 4 > me->slot_num * 3) {
+        retVal = dictionary_grow(me);
+        if (0 != retVal) {
+            return retVal;
         }
+        i = dictionary_find_slot(me, key, hash);
+    }
+    retVal = vector_add_last(me->keys, key);
+    if (0 != retVal) {
         return retVal;
     }
+    retVal = vector_add_last(me->values, value);
+    if (0 != retVal) {
+        vector_remove_last(me->keys);
+        return retVal;
+    }
+    me->slots[i].hash  = hash;
+    me->slots[i].index = vector_size(me->keys);
+
+    return 0;
 }
 
 int
 dictionary_get(void *value, dictionary me, void *key)
 {
-    return map_get(value, me->body, key);
+    int	i = dictionary_find_slot(me, key, me->hash(key));
+
+    if (0 == me->slots[i].index) {
+        return 0;
+    }
+    memcpy(value, (const char*)vector_get_data(me->values)
+        + (size_t)(me->slots[i].index - 1) * me->value_size, me->value_size);
+
+    return 1;
 }
 
 int
 dictionary_contains(dictionary me, void *key)
 {
-    return map_contains(me->body, key);
+    int	i = dictionary_find_slot(me, key, me->hash(key));
+
+    return (0 != me->slots[i].index);
 }
 
 int
 dictionary_remove(dictionary me, void *key)
 {
-    if (map_remove(me->body, key)) {
-        const char*	keyCurs = (char*)vector_get_data(me->keys);
+    int	i = dictionary_find_slot(me, key, me->hash(key));
+    int	index = me->slots[i].index - 1;
+    int	last  = vector_size(me->keys) - 1;
 
-        for (int i = 0, n = vector_size(me->keys); i < n; ++i) {
-            if (0 == me->comparator(key, keyCurs)) {
-                vector_remove_at(me->keys, i);
-                break;
-            }
-            keyCurs += me->key_size;
-        }
-
-        return 1;
-    } else {
+    if (index < 0) {
         return 0;
     }
+
+    // move the last entry into the place of the removed one
+    if (index != last) {
+        char*	keys    = (char*)vector_get_data(me->keys);
+        char*	values  = (char*)vector_get_data(me->values);
+        char*	lastKey = keys + (size_t)last * me->key_size;
+        int	j = dictionary_find_slot(me, lastKey, me->hash(lastKey));
+
+        me->slots[j].index = index + 1;
+        memcpy(keys + (size_t)index * me->key_size,
+            keys + (size_t)last * me->key_size, me->key_size);
+        memcpy(values + (size_t)index * me->value_size,
+            values + (size_t)last * me->value_size, me->value_size);
+    }
+    vector_remove_last(me->keys);
+    vector_remove_last(me->values);
+    dictionary_clear_slot(me, i);
+
+    return 1;
 }
 
 vector
@@ -132,15 +290,19 @@ dictionary_get_keys(dictionary me)
 void
 dictionary_clear(dictionary me)
 {
-    map_clear(me->body);
-    vector_clear(me->keys);
+    // keep the capacity for the entries added again
+    while (0 == vector_remove_last(me->keys)) {
+        vector_remove_last(me->values);
+    }
+    memset(me->slots, 0, (size_t)me->slot_num * sizeof(dictionary_slot));
 }
 
 dictionary
 dictionary_destroy(dictionary me)
 {
-    map_destroy(me->body);
     vector_destroy(me->keys);
+    vector_destroy(me->values);
+    free(me->slots);
     free(me);
 
     return NULL;
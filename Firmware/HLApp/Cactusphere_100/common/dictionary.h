@@ -29,12 +29,22 @@
 #include "vector.h"
 #endif
 
+/**
+ * The dictionary, which is an open-addressing hash table. The keys and the
+ * values are stored inline in contiguous arrays, in the order of addition
+ * (removing a key moves the last one into its place).
+ */
 typedef struct internal_dictionary	*dictionary;
 
 /* Starting */
 dictionary dictionary_init(size_t key_size,
     size_t value_size,
-    int(*comparator)(const void *const one, const void *const two));
+    int(*comparator)(const void *const one, const void *const two),
+    unsigned int(*hash)(const void *const key));
+
+/* Hash functions (consistent with strcmp() of the keys) */
+unsigned int dictionary_hash_chars(const void *const key);   /* char[] key */
+unsigned int dictionary_hash_string(const void *const key);  /* char* key */
 
 /* Capacity */
 int dictionary_size(dictionary me);
@@ -1107,3 +1107,30 @@ bool json_GetIntValue(const json_value* jsonObj, uint32_t* value, int base) {
    }
    return ret;
 }
+
+bool json_GetDoubleValue(const json_value* jsonObj, double* value) {
+   bool ret = false;
+   if (jsonObj) {
+      switch (jsonObj->type)
+      {
+      case json_integer:
+         *value = (double)jsonObj->u.integer;
+         ret = true;
+         break;
+      case json_double:
+         *value = jsonObj->u.dbl;
+         ret = true;
+         break;
+      case json_string:
+         *value = strtod(jsonObj->u.string.ptr, NULL);
+         ret = true;
+         break;
+      case json_object:
+         ret = json_GetDoubleValue(jsonObj->u.object.values[0].value, value);
+         break;
+      default:
+         break;
+      }
+   }
+   return ret;
+}
@@ -286,6 +286,8 @@ bool json_GetBoolValue(const json_value* jsonObj, bool* value);
 
 bool json_GetIntValue(const json_value* jsonObj, uint32_t* value, int base);
 
+bool json_GetDoubleValue(const json_value* jsonObj, double* value);
+
 #ifdef __cplusplus
    } /* extern "C" */
 #endif
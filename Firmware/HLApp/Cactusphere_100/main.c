@@ -52,6 +52,7 @@
 // Azure IoT SDK
 #include <iothub_client_core_common.h>
 #include <iothub_device_client_ll.h>
+#include <iothub_client_core_ll.h>
 #include <iothub_client_options.h>
 #include <iothubtransportmqtt.h>
 #include <iothub.h>
@@ -104,6 +105,7 @@ static volatile sig_atomic_t exitCode = ExitCode_Success;
 
 #include "LibCloud.h"
 #include "DataFetchScheduler.h"
+#include "FieldBusWorker.h"
 #include "SendRTApp.h"
 #include "TelemetryItems.h"
 #include "PropertyItems.h"
@@ -180,7 +182,7 @@ static const char *EventStatusToString(SysEvent_Status status);
 static const char *UpdateTypeToString(SysEvent_UpdateType updateType);
 
 static int CommandCallback(const char* method_name, const unsigned char* payload, size_t size,
-    unsigned char** response, size_t* response_size, void* userContextCallback);
+    METHOD_HANDLE method_id, void* userContextCallback);
 static void TwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned char *payload,
                          size_t payloadSize, void *userContextCallback);
 static const char *GetReasonString(IOTHUB_CLIENT_CONNECTION_STATUS_REASON reason);
@@ -295,6 +297,9 @@ int main(int argc, char *argv[])
     int err;
     Log_Debug("IoT Hub/Central Application starting.\n");
 
+    if (! FieldBusWorker_Initialize()) {
+        return ExitCode_Init_EventLoop;
+    }
 #ifdef USE_MODBUS
     mTelemetrySchedulerArr[MODBUS_RTU] = Factory_CreateScheduler(MODBUS_RTU);
     ModbusConfigMgr_Initialize();
@@ -340,6 +345,11 @@ int main(int argc, char *argv[])
     }
 
     exitCode = InitPeripheralsAndHandlers();
+    if (exitCode == ExitCode_Success
+        && (! DataFetchScheduler_StartDelivery(eventLoop)
+            || ! FieldBusWorker_Start(eventLoop))) {
+        exitCode = ExitCode_Init_EventLoop;
+    }
 
     // Main loop
     while (exitCode == ExitCode_Success) {
@@ -350,6 +360,7 @@ int main(int argc, char *argv[])
         }
     }
 
+    FieldBusWorker_Stop();
     TelemetryItems_CleanupDictionary();
 #ifdef USE_MODBUS
     ModbusConfigMgr_Cleanup();
@@ -369,8 +380,8 @@ int main(int argc, char *argv[])
             DataFetchScheduler_Destroy(scheduler);
         }
     }
-
     SendRTApp_CloseHandlers();
+    FieldBusWorker_Cleanup();
 
     while(ct_error < 0) {
         // hang
@@ -411,19 +422,7 @@ static void AzureTimerEventHandler(EventLoopTimer *timer)
         Log_Debug("Failed to get Network state\n");
     }
 
-    if (ct_error < 0) {
-        goto dowork;
-    }
-
-    for (int i = 0; i < MAX_SCHEDULER_NUM; i++) {
-        DataFetchScheduler* scheduler = mTelemetrySchedulerArr[i];
-
-        if (NULL != scheduler) {
-            DataFetchScheduler_Schedule(scheduler);
-        }
-    }
-
-dowork:
+    // (data acquisition is driven by each scheduler's fetch timers)
     if (iothubAuthenticated) {
         IoTHubDeviceClient_LL_DoWork(iothubClientHandle);
     }
@@ -822,6 +821,36 @@ static void ClosePeripheralsAndHandlers(void)
     EventLoop_Close(eventLoop);
 }
 
+// RTApp version read on the field bus thread
+typedef struct RTAppVersionJob {
+    char rtAppVersion[256];
+    bool isRead;
+} RTAppVersionJob;
+
+static void ReadRTAppVersionJob(void* context)
+{
+    RTAppVersionJob* job = (RTAppVersionJob*)context;
+
+#if defined USE_DI
+    job->isRead = DI_Lib_ReadRTAppVersion(job->rtAppVersion);
+#elif defined USE_MODBUS
+    job->isRead = Libmodbus_GetRTAppVersion(job->rtAppVersion);
+#endif
+}
+
+static void RTAppVersionJobDone(void* context, bool isCancelled)
+{
+    static const char* EventMsgTemplate = "{ \"%s\": \"%s\" }";
+    static char propertyStr[280] = { 0 };
+    RTAppVersionJob* job = (RTAppVersionJob*)context;
+
+    if (! isCancelled && job->isRead) {
+        snprintf(propertyStr, sizeof(propertyStr), EventMsgTemplate, "RTAppVersion", job->rtAppVersion);
+        IoT_CentralLib_SendProperty(propertyStr);
+    }
+    free(job);
+}
+
 /// <summary>
 ///     Sets the IoT Hub authentication state for the app
 ///     The SAS Token expires which will set the authentication state
@@ -853,17 +882,11 @@ static void HubConnectionStatusCallback(IOTHUB_CLIENT_CONNECTION_STATUS result,
             // HLApp
             snprintf(propertyStr, sizeof(propertyStr), EventMsgTemplate, "HLAppVersion", HLAPP_VERSION);
             IoT_CentralLib_SendProperty(propertyStr);
-            // RTApp
-            char rtAppVersion[256] = { 0 };
-            bool ret = false;
-#if defined USE_DI
-            ret = DI_Lib_ReadRTAppVersion(rtAppVersion);
-#elif defined USE_MODBUS
-            ret = Libmodbus_GetRTAppVersion(rtAppVersion);
-#endif
-            if (ret) {
-                snprintf(propertyStr, sizeof(propertyStr), EventMsgTemplate, "RTAppVersion", rtAppVersion);
-                IoT_CentralLib_SendProperty(propertyStr);
+            // RTApp (read by the field bus thread, sent on completion)
+            RTAppVersionJob* versionJob = (RTAppVersionJob*)calloc(1, sizeof(RTAppVersionJob));
+            if (NULL != versionJob &&
+                ! FieldBusWorker_PostJob(ReadRTAppVersionJob, RTAppVersionJobDone, versionJob)) {
+                free(versionJob);
             }
 
             gLedState = LED_ON;
@@ -970,7 +993,8 @@ static void SetupAzureClient(void)
     IoTHubDeviceClient_LL_SetDeviceTwinCallback(iothubClientHandle, TwinCallback, NULL);
     IoTHubDeviceClient_LL_SetConnectionStatusCallback(iothubClientHandle,
                                                       HubConnectionStatusCallback, NULL);
-    IoTHubDeviceClient_LL_SetDeviceMethodCallback(iothubClientHandle, CommandCallback, NULL);
+    // (the method is responded asynchronously after the field bus thread runs it)
+    IoTHubClientCore_LL_SetDeviceMethodCallback_Ex(iothubClientHandle, CommandCallback, NULL);
 }
 
 /// <summary>
@@ -1137,82 +1161,72 @@ static bool CheckDeferredUpdateConfig(const unsigned char* payload,
     return ret;
 }
 
-/// <summary>
-///     Callback invoked when a Device Twin update is received from IoT Hub.
-///     Updates local state for 'showEvents' (bool).
-/// </summary>
-/// <param name="payload">contains the Device Twin JSON document (desired and reported)</param>
-/// <param name="payloadSize">size of the Device Twin JSON document</param>
-static void TwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned char *payload,
-                         size_t payloadSize, void *userContextCallback)
-{
-    if (ct_error < 0) {
-        return;
-    }
-
-    vector Send_PropertyItem = vector_init(sizeof(ResponsePropertyItem));
+// Device Twin update applied on the field bus thread
+typedef struct TwinUpdateJob {
+    unsigned char* payload;     // copy of the Device Twin JSON document
+    size_t payloadSize;
+    bool isDeferredUpdate;      // whether the update configuration was included
+    vector propertyItems;       // properties to respond
+    SphereWarning err;          // result of loading the configuration
+} TwinUpdateJob;
 
-    bool defupderr = CheckDeferredUpdateConfig(payload, payloadSize, Send_PropertyItem);
+static void ApplyTwinUpdateJob(void* context)
+{
+    // load the configuration and restart the acquisition with it
+    TwinUpdateJob* job = (TwinUpdateJob*)context;
 
+    job->err = NO_ERROR;
 #ifdef USE_MODBUS
-    SphereWarning err = ModbusConfigMgr_LoadAndApplyIfChanged(payload, payloadSize, Send_PropertyItem);
-    if (defupderr && err == UNSUPPORTED_PROPERTY) {
-        err = NO_ERROR;
+    job->err = ModbusConfigMgr_LoadAndApplyIfChanged(job->payload, job->payloadSize, job->propertyItems);
+    if (job->isDeferredUpdate && job->err == UNSUPPORTED_PROPERTY) {
+        job->err = NO_ERROR;
     }
-    switch (err)
-    {
-    case NO_ERROR:
-    case ILLEGAL_PROPERTY:
+    if (job->err == NO_ERROR || job->err == ILLEGAL_PROPERTY) {
         DataFetchScheduler_Init(
             mTelemetrySchedulerArr[MODBUS_RTU],
             ModbusFetchConfig_GetFetchItemPtrs(ModbusConfigMgr_GetModbusFetchConfig()));
-
-        if (err == NO_ERROR) {
-            gLedState = LED_ON;
-        } else { // ILLEGAL_PROPERTY
-            // do not set ct_error and exitCode,
-            // as it won't hang with this error.
-            Log_Debug("ERROR: Receive illegal property.\n");
-            gLedState = LED_BLINK;
-            cactusphere_error_notify(err);
-        }
-        break;
-    case ILLEGAL_DESIRED_PROPERTY:
-        Log_Debug("ERROR: Receive illegal desired property.\n");
-        ct_error = -(int)err;
-        break;
-    case UNSUPPORTED_PROPERTY:
-        Log_Debug("ERROR: Receive unsupported property.\n");
-        ct_error = -(int)err;
-        break;
-
-    default:
-        break;
     }
-    SendPropertyResponse(Send_PropertyItem);
 #endif  // USE_MODBUS
 
 #ifdef USE_MODBUS_TCP
-    ModbusTcpConfigMgr_LoadAndApplyIfChanged(payload, payloadSize);
+    ModbusTcpConfigMgr_LoadAndApplyIfChanged(job->payload, job->payloadSize);
     DataFetchScheduler_Init(
         mTelemetrySchedulerArr[MODBUS_TCP],
         ModbusTcpFetchConfig_GetFetchItemPtrs(ModbusTcpConfigMgr_GetModbusFetchConfig()));
 #endif // USE_MODBUS_TCP
 
 #ifdef USE_DI
-    SphereWarning err = DI_ConfigMgr_LoadAndApplyIfChanged(payload, payloadSize, Send_PropertyItem);
-    if (defupderr && err == UNSUPPORTED_PROPERTY) {
-        err = NO_ERROR;
+    job->err = DI_ConfigMgr_LoadAndApplyIfChanged(job->payload, job->payloadSize, job->propertyItems);
+    if (job->isDeferredUpdate && job->err == UNSUPPORTED_PROPERTY) {
+        job->err = NO_ERROR;
     }
-    switch (err)
-    {
-    case NO_ERROR:
-    case ILLEGAL_PROPERTY:
+    if (job->err == NO_ERROR || job->err == ILLEGAL_PROPERTY) {
         DI_DataFetchScheduler_Init(
             mTelemetrySchedulerArr[DIGITAL_IN],
             DI_FetchConfig_GetFetchItemPtrs(DI_ConfigMgr_GetFetchConfig()),
             DI_WatchConfig_GetFetchItems(DI_ConfigMgr_GetWatchConfig()));
-        SendPropertyResponse(Send_PropertyItem);
+    }
+#endif  // USE_DI
+}
+
+static void TwinUpdateJobDone(void* context, bool isCancelled)
+{
+    // report the result of ApplyTwinUpdateJob() (main thread)
+    TwinUpdateJob* job = (TwinUpdateJob*)context;
+    SphereWarning err = job->err;
+
+    if (isCancelled) {
+        goto end;
+    }
+
+#if defined USE_MODBUS || defined USE_DI
+    switch (err)
+    {
+    case NO_ERROR:
+    case ILLEGAL_PROPERTY:
+#ifdef USE_DI
+        SendPropertyResponse(job->propertyItems);
+#endif  // USE_DI
 
         if (err == NO_ERROR) {
             gLedState = LED_ON;
@@ -1236,9 +1250,10 @@ static void TwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned ch
     default:
         break;
     }
-
-#endif  // USE_DI
-    vector_destroy(Send_PropertyItem);
+#ifdef USE_MODBUS
+    SendPropertyResponse(job->propertyItems);
+#endif  // USE_MODBUS
+#endif  // USE_MODBUS || USE_DI
 
     if (ct_error < 0) {
         // hang
@@ -1246,31 +1261,169 @@ static void TwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned ch
         cactusphere_error_notify(err);
         exitCode = ExitCode_TermHandler_SigTerm;
     }
-}
 
-static int CommandCallback(const char* method_name, const unsigned char* payload, size_t size,
-    unsigned char** response, size_t* response_size, void* userContextCallback) {
+end:
+    vector_destroy(job->propertyItems);
+    free(job->payload);
+    free(job);
+}
 
+/// <summary>
+///     Callback invoked when a Device Twin update is received from IoT Hub.
+///     The configuration is applied by the field bus thread, so that the bus
+///     access doesn't block the communication with IoT Hub.
+/// </summary>
+/// <param name="payload">contains the Device Twin JSON document (desired and reported)</param>
+/// <param name="payloadSize">size of the Device Twin JSON document</param>
+static void TwinCallback(DEVICE_TWIN_UPDATE_STATE updateState, const unsigned char *payload,
+                         size_t payloadSize, void *userContextCallback)
+{
     if (ct_error < 0) {
-        goto end;
+        return;
+    }
+
+    TwinUpdateJob* job = (TwinUpdateJob*)calloc(1, sizeof(TwinUpdateJob));
+
+    if (NULL == job) {
+        Log_Debug("ERROR: failed to allocate Device Twin update.\n");
+        return;
+    }
+    job->payload = (unsigned char*)malloc(payloadSize + 1);
+    job->propertyItems = vector_init(sizeof(ResponsePropertyItem));
+    if (NULL == job->payload || NULL == job->propertyItems) {
+        goto err;
+    }
+    memcpy(job->payload, payload, payloadSize);
+    job->payload[payloadSize] = '\0';
+    job->payloadSize = payloadSize;
+
+    job->isDeferredUpdate = CheckDeferredUpdateConfig(payload, payloadSize, job->propertyItems);
+
+    if (! FieldBusWorker_PostJob(ApplyTwinUpdateJob, TwinUpdateJobDone, job)) {
+        goto err;
     }
+    return;
 
+err:
+    Log_Debug("ERROR: failed to post Device Twin update.\n");
+    if (NULL != job->propertyItems) {
+        vector_destroy(job->propertyItems);
+    }
+    free(job->payload);
+    free(job);
+}
+
+// Direct method run on the field bus thread
+typedef struct CommandJob {
+    METHOD_HANDLE methodId;             // to respond the method
+#ifdef USE_MODBUS
+    unsigned char* payload;             // copy of the method payload
+    size_t size;
+#endif  // USE_MODBUS
+#ifdef USE_DI
+    int pinId;                          // counter to reset
+    unsigned long initVal;              // initial value of the counter
+    bool isResetDone;                   // result of the reset
+#endif  // USE_DI
     char deviceMethodResponse[100];
     char reportedPropertiesString[100];
+} CommandJob;
+
+static void CommandJobDone(void* context, bool isCancelled)
+{
+    // respond the method and report the result (main thread)
+    CommandJob* job = (CommandJob*)context;
+
+    if (! isCancelled) {
+#ifdef USE_DI
+        static const char* ReportMsgTemplate = "{ \"ClearCounterResult_DI%d\": \"%s\" }";
 
+        if (job->pinId >= 0) {
+            const char* result = job->isResetDone ? "Success" : "Reset Error";
+
+            if (! job->isResetDone) {
+                Log_Debug("DI_Lib_ResetPulseCount() error");
+            }
+            snprintf(job->deviceMethodResponse, sizeof(job->deviceMethodResponse), "\"%s\"", result);
+            snprintf(job->reportedPropertiesString, sizeof(job->reportedPropertiesString),
+                ReportMsgTemplate, job->pinId + DI_PORT_OFFSET, result);
+        }
+#endif  // USE_DI
 #ifdef USE_MODBUS
-    static const char* ReportMsgTemplate = "{ \"ModbusWriteRegisterResult\": \"%s\" }";
+        static const char* ReportMsgTemplate = "{ \"ModbusWriteRegisterResult\": \"%s\" }";
 
-    ModbusOneshotcommand(payload, size, deviceMethodResponse);
+        if (NULL != job->payload) {
+            snprintf(job->reportedPropertiesString, sizeof(job->reportedPropertiesString),
+                ReportMsgTemplate, job->deviceMethodResponse);
+        }
+#endif  // USE_MODBUS
 
-    // send result
-    *response_size = strlen(deviceMethodResponse);
-    *response = malloc(*response_size);
-    if (NULL != response) {
-        (void)memcpy(*response, deviceMethodResponse, *response_size);
+        // send result
+        IoTHubDeviceClient_LL_DeviceMethodResponse(iothubClientHandle, job->methodId,
+            (const unsigned char*)job->deviceMethodResponse, strlen(job->deviceMethodResponse), 200);
+        if ('\0' != job->reportedPropertiesString[0]) {
+            IoT_CentralLib_SendProperty(job->reportedPropertiesString);
+        }
     }
-    snprintf(reportedPropertiesString, sizeof(reportedPropertiesString), ReportMsgTemplate, deviceMethodResponse);
-    IoT_CentralLib_SendProperty(reportedPropertiesString);
+#ifdef USE_MODBUS
+    free(job->payload);
+#endif  // USE_MODBUS
+    free(job);
+}
+
+#ifdef USE_MODBUS
+static void ModbusOneshotCommandJob(void* context)
+{
+    CommandJob* job = (CommandJob*)context;
+
+    ModbusOneshotcommand(job->payload, job->size, job->deviceMethodResponse);
+}
+#endif  // USE_MODBUS
+
+#ifdef USE_DI
+static void ResetPulseCountJob(void* context)
+{
+    CommandJob* job = (CommandJob*)context;
+
+    job->isResetDone = DI_Lib_ResetPulseCount((unsigned long)job->pinId, job->initVal);
+}
+#endif  // USE_DI
+
+static int CommandCallback(const char* method_name, const unsigned char* payload, size_t size,
+    METHOD_HANDLE method_id, void* userContextCallback) {
+
+    // The bus access is run by the field bus thread, and the method is
+    // responded on its completion (CommandJobDone()).
+    CommandJob* job = (CommandJob*)calloc(1, sizeof(CommandJob));
+
+    if (NULL == job) {
+        return -1;
+    }
+    job->methodId = method_id;
+#ifdef USE_DI
+    job->pinId = -1;  // no reset
+#endif  // USE_DI
+
+    if (ct_error < 0) {
+        strcpy(job->deviceMethodResponse, "\"Error\"");
+        goto end;
+    }
+
+#ifdef USE_MODBUS
+    job->payload = (unsigned char*)malloc(size + 1);
+    if (NULL == job->payload) {
+        strcpy(job->deviceMethodResponse, "\"Error\"");
+        goto end;
+    }
+    memcpy(job->payload, payload, size);
+    job->payload[size] = '\0';
+    job->size = size;
+    if (FieldBusWorker_PostJob(ModbusOneshotCommandJob, CommandJobDone, job)) {
+        return 0;
+    }
+    free(job->payload);
+    job->payload = NULL;
+    strcpy(job->deviceMethodResponse, "\"Error\"");
 #endif
 
 #ifdef USE_DI
@@ -1292,42 +1445,33 @@ static int CommandCallback(const char* method_name, const unsigned char* payload
             strncpy(cmdPayload, payload, size);
             uint64_t initVal = strtoull(cmdPayload, NULL, 10);
 
+            free(cmdPayload);
             if (initVal > 0x7FFFFFFF) {
-                free(cmdPayload);
                 goto err_value;
             }
-            if (!DI_Lib_ResetPulseCount((unsigned long)pinId, (unsigned long)initVal)) {
-                Log_Debug("DI_Lib_ResetPulseCount() error");
-                strcpy(deviceMethodResponse, "\"Reset Error\"");
-                snprintf(reportedPropertiesString, sizeof(reportedPropertiesString), ReportMsgTemplate, pinId + DI_PORT_OFFSET, "Reset Error");
-            } else {
-                strcpy(deviceMethodResponse, "\"Success\"");
-                snprintf(reportedPropertiesString, sizeof(reportedPropertiesString), ReportMsgTemplate, pinId + DI_PORT_OFFSET, "Success");
+            job->pinId   = pinId;
+            job->initVal = (unsigned long)initVal;
+            if (FieldBusWorker_PostJob(ResetPulseCountJob, CommandJobDone, job)) {
+                return 0;
             }
-
-            free(cmdPayload);
+            job->pinId = -1;
+            goto err;
         } else {
 err_value:
             //init value error
-            strcpy(deviceMethodResponse, "\"Illegal init value\"");
-            snprintf(reportedPropertiesString, sizeof(reportedPropertiesString), ReportMsgTemplate, pinId + DI_PORT_OFFSET, "Illegal init value");
+            strcpy(job->deviceMethodResponse, "\"Illegal init value\"");
+            snprintf(job->reportedPropertiesString, sizeof(job->reportedPropertiesString), ReportMsgTemplate, pinId + DI_PORT_OFFSET, "Illegal init value");
         }
     } else {
 err:
-        strcpy(deviceMethodResponse, "\"Error\"");
-    }
-
-    // send result
-    *response_size = strlen(deviceMethodResponse);
-    *response = malloc(*response_size);
-    if (NULL != response) {
-        (void)memcpy(*response, deviceMethodResponse, *response_size);
+        strcpy(job->deviceMethodResponse, "\"Error\"");
     }
-    IoT_CentralLib_SendProperty(reportedPropertiesString);
-
 #endif  // USE_DI
+
 end:
-    return 200;
+    // respond now without the bus access
+    CommandJobDone(job, false);
+    return 0;
 }
 
 /// <summary>
@@ -37,6 +37,8 @@ enum {
     DI_READ_DUTY_SUM_TIME   = 4,  // read the time integration of pulse
     DI_READ_PULSE_LEVEL     = 5,  // read the input level of all DI pin
     DI_READ_PIN_LEVEL       = 6,  // read the input level of specific DI pin
+    DI_SET_SAMPLE_STREAM    = 7,  // select the pins which stream their edges
+    DI_READ_STATS           = 8,  // read the performance statistics (InterCoreStats)
     DI_READ_VERSION         = 255,// read the RTApp version
 };
 
@@ -75,6 +77,20 @@ typedef struct DI_MsgPinId {
 // sizeof(DI_MsgPinId) == messageLen
 //
 } DI_MsgPinId;
+    // DI_SET_SAMPLE_STREAM
+typedef struct DI_MsgSampleStream {
+    uint32_t	pinMask;  // bit n: stream the edges of pin n
+//
+// sizeof(DI_MsgSampleStream) == messageLen
+//
+} DI_MsgSampleStream;
+    // DI_READ_STATS
+typedef struct DI_MsgStats {
+    uint32_t	reset;  // reset the statistics after read (0: keep)
+//
+// sizeof(DI_MsgStats) == messageLen
+//
+} DI_MsgStats;
 
 // union of messages
 typedef struct DI_DriverMsg {
@@ -83,6 +99,8 @@ typedef struct DI_DriverMsg {
         DI_MsgSetConfig        setConfig;
         DI_MsgResetPulseCount  resetPulseCount;
         DI_MsgPinId            pinId;
+        DI_MsgSampleStream     sampleStream;
+        DI_MsgStats            stats;
     } body;
 } DI_DriverMsg;
 
@@ -29,101 +29,399 @@
 
 #include "mt3620-intercore.h"
 
+#include "PerfStats.h"
 #include "TimerUtil.h"
 
+#define INTERCORE_PREFIX_LEN	20  // GUID(16[Byte]) + reserved(4[Byte]) prefix
+#define MSG_BUF_SIZE	512
+#define REQUEST_QUEUE_NUM	4   // requests received ahead of processing
+#define SAMPLE_RING_NUM	256     // samples waiting to be sent (power of 2)
+#define SAMPLE_FLUSH_MS	100     // max delay of a sample before sent
+
+// received request
+typedef struct RequestSlot {
+    uint32_t	dataSize;
+    unsigned char	buf[MSG_BUF_SIZE];
+} RequestSlot;
+
 static BufferHeader*	sOutboundBuf = NULL;
 static BufferHeader*	sInboundBuf  = NULL;
 static uint32_t	sRingBufSize;
-static unsigned char	sRecvBuf[512];
-static DI_DriverMsg*	sDriverMsgBuf = NULL;
+static unsigned char	sSendBuf[MSG_BUF_SIZE];  // for the reply which wraps around the ring
+static unsigned char*	sReplyBuf = NULL;        // reserved reply (in the ring or sSendBuf)
+static bool	sIsReplyInRing = false;
+static RequestSlot	sRequests[REQUEST_QUEUE_NUM];
+static uint32_t	sRequestHead  = 0;
+static uint32_t	sRequestCount = 0;
+static bool	sHasCurrent = false;      // sRequests[sRequestHead] is being processed
+static uint32_t	sCurrentStartUs;          // time when the current request was taken
+static InterCoreMsgHdr	sCurrentHdr;  // header of the request being processed
+static unsigned char	sPeerPrefix[INTERCORE_PREFIX_LEN];  // GUID prefix of HLApp
+static bool	sHasPeer = false;
+static InterCoreSample	sSamples[SAMPLE_RING_NUM];
+static volatile uint32_t	sSampleHead = 0;     // advanced by the producer
+static volatile uint32_t	sSampleTail = 0;     // advanced by InterCoreComm_FlushSamples()
+static volatile uint32_t	sSampleDropped = 0;  // counted by the producer
+static uint32_t	sSampleDroppedSent = 0;
+static uint32_t	sSampleSeq = 0;
+static bool	sIsFlushBlocked = false;  // HLApp didn't read the last batch
 
 static bool
-InterCoreComm_SendData(const uint8_t* data, uint16_t len)
+InterCoreComm_SendReply(uint16_t status, const uint8_t* data, uint16_t len)
 {
-    memcpy(sRecvBuf + 20, data, len);
+    uint8_t*	payload = InterCoreComm_ReserveReply(len);
+
+    if (NULL == payload) {
+        return false;
+    }
+    if (0 < len) {
+        memcpy(payload, data, len);
+    }
 
-    return (0 == EnqueueData(sInboundBuf, sOutboundBuf, sRingBufSize,
-        sRecvBuf, 20 + len));
+    return InterCoreComm_CommitReply(status, len);
 }
 
-// Initialization
-bool
-InterCoreComm_Initialize()
+// Send the samples in a batch, when enough of them are stored or
+// the oldest one has waited for SAMPLE_FLUSH_MS
+static void
+InterCoreComm_FlushSamples(void)
 {
-    if (0 != GetIntercoreBuffers(
-            &sOutboundBuf, &sInboundBuf, &sRingBufSize)) {
-        return false;
+    uint32_t	tail    = sSampleTail;
+    uint32_t	count   = sSampleHead - tail;
+    uint32_t	dropped = sSampleDropped;
+    uint32_t	size;
+    uint32_t	first;
+    uint8_t*	block;
+    bool	isInRing;
+    InterCoreMsgHdr*	hdr;
+    InterCoreSampleBatch*	batch;
+    InterCoreSample*	records;
+
+    if (! sHasPeer || (0 == count && dropped == sSampleDroppedSent)) {
+        return;  // nothing to send (or don't know where to)
+    }
+    if (0 < count && count < INTERCORE_SAMPLE_BATCH_MAX
+        && TimerUtil_GetMicroseconds() - sSamples[tail % SAMPLE_RING_NUM].timestamp
+            < SAMPLE_FLUSH_MS * 1000) {
+        return;  // wait for more samples
+    }
+    if (count > INTERCORE_SAMPLE_BATCH_MAX) {
+        count = INTERCORE_SAMPLE_BATCH_MAX;
     }
-    sDriverMsgBuf = (DI_DriverMsg*)(sRecvBuf + 20);  // GUID(16[Byte]) + reserved(4[Byte]) prefix
 
-    return true;
+    // build the batch in the ring
+    size = INTERCORE_PREFIX_LEN + sizeof(InterCoreMsgHdr)
+        + sizeof(InterCoreSampleBatch) + count * sizeof(InterCoreSample);
+    block = ReserveData(sInboundBuf, sOutboundBuf, sRingBufSize, size);
+    isInRing = (NULL != block);
+    if (! isInRing) {
+        block = sSendBuf;  // would wrap around the end of the ring
+    }
+    memcpy(block, sPeerPrefix, INTERCORE_PREFIX_LEN);
+    hdr = (InterCoreMsgHdr*)(block + INTERCORE_PREFIX_LEN);
+    hdr->version    = INTERCORE_PROTOCOL_VERSION;
+    hdr->flags      = INTERCORE_FLAG_SAMPLES;
+    hdr->status     = INTERCORE_STATUS_OK;
+    hdr->seq        = sSampleSeq;
+    hdr->payloadLen = sizeof(InterCoreSampleBatch) + count * sizeof(InterCoreSample);
+    batch = (InterCoreSampleBatch*)(hdr + 1);
+    batch->dropped = dropped - sSampleDroppedSent;
+    batch->count   = count;
+    records = (InterCoreSample*)(batch + 1);
+    first = SAMPLE_RING_NUM - tail % SAMPLE_RING_NUM;
+    if (first > count) {
+        first = count;
+    }
+    memcpy(records, &sSamples[tail % SAMPLE_RING_NUM], first * sizeof(InterCoreSample));
+    memcpy(records + first, &sSamples[0], (count - first) * sizeof(InterCoreSample));
+
+    if (isInRing) {
+        CommitData(sOutboundBuf, sRingBufSize, size);
+    } else if (0 != EnqueueData(sInboundBuf, sOutboundBuf, sRingBufSize, block, size)) {
+        sIsFlushBlocked = true;
+        return;  // HLApp doesn't read, keep them and retry later
+    }
+    sIsFlushBlocked = false;
+    sSampleSeq++;
+    sSampleDroppedSent = dropped;
+    sSampleTail = tail + count;
 }
 
-// Wait and receive request from HLApp
-const DI_DriverMsg*
-InterCoreComm_WaitAndRecvRequest()
+// Receive the requests arrived from HLApp into the queue
+static void
+InterCoreComm_FetchRequests(void)
 {
-    uint32_t	dataSize;
-    DI_DriverMsgHdr*	msgHdr;
+    while (sRequestCount < REQUEST_QUEUE_NUM) {
+        RequestSlot*	slot = &sRequests[
+            (sRequestHead + sRequestCount) % REQUEST_QUEUE_NUM];
 
-    // wait request message arrives while sleep
-    while (true) {
-        dataSize = sizeof(sRecvBuf);
-        if (0 == DequeueData(sOutboundBuf, sInboundBuf,
-                sRingBufSize, sRecvBuf, &dataSize)) {
+        slot->dataSize = sizeof(slot->buf);
+        if (0 != DequeueData(sOutboundBuf, sInboundBuf,
+                sRingBufSize, slot->buf, &slot->dataSize)) {
             break;
         }
-        TimerUtil_SleepUntilIntr();
+        sRequestCount++;
     }
-    msgHdr = &sDriverMsgBuf->header;
+}
 
-    // check the received message's integrity
-    if (dataSize <= sizeof(DI_DriverMsgHdr)) {
-        return NULL;  // too short message
+// Check the request's integrity, returns INTERCORE_STATUS_xx
+static uint16_t
+InterCoreComm_CheckRequest(const DI_DriverMsg* msg, uint32_t msgSize)
+{
+    const DI_DriverMsgHdr*	msgHdr = &msg->header;
+
+    if (msgSize < sizeof(DI_DriverMsgHdr)
+        || msgSize - sizeof(DI_DriverMsgHdr) < msgHdr->messageLen) {
+        return INTERCORE_STATUS_BAD_REQUEST;  // too short message
     }
     switch (msgHdr->requestCode) {
     case DI_SET_CONFIG_AND_START:
         if (msgHdr->messageLen != sizeof(DI_MsgSetConfig)) {
-            return NULL;  // invalid length
+            return INTERCORE_STATUS_BAD_REQUEST;  // invalid length
         }
-        break; 
+        break;
     case DI_PULSE_COUNT_RESET:
         if (msgHdr->messageLen != sizeof(DI_MsgResetPulseCount)) {
-            return NULL;  // invalid length
+            return INTERCORE_STATUS_BAD_REQUEST;  // invalid length
         }
         break;
     case DI_READ_PULSE_COUNT:
     case DI_READ_DUTY_SUM_TIME:
     case DI_READ_PIN_LEVEL:
         if (msgHdr->messageLen != sizeof(DI_MsgPinId)) {
-            return NULL;  // invalid length
+            return INTERCORE_STATUS_BAD_REQUEST;  // invalid length
+        }
+        break;
+    case DI_SET_SAMPLE_STREAM:
+        if (msgHdr->messageLen != sizeof(DI_MsgSampleStream)) {
+            return INTERCORE_STATUS_BAD_REQUEST;  // invalid length
+        }
+        break;
+    case DI_READ_STATS:
+        if (msgHdr->messageLen != sizeof(DI_MsgStats)) {
+            return INTERCORE_STATUS_BAD_REQUEST;  // invalid length
         }
         break;
     case DI_READ_PULSE_LEVEL:
     case DI_READ_VERSION:
         if (msgHdr->messageLen != 0) {
-            return NULL;  // invalid length
+            return INTERCORE_STATUS_BAD_REQUEST;  // invalid length
         }
         break;
     default:
-        return NULL;  // unknown messagse
+        return INTERCORE_STATUS_UNKNOWN;  // unknown messagse
+    }
+
+    return INTERCORE_STATUS_OK;
+}
+
+// Initialization
+bool
+InterCoreComm_Initialize()
+{
+    if (0 != GetIntercoreBuffers(
+            &sOutboundBuf, &sInboundBuf, &sRingBufSize)) {
+        return false;
+    }
+    // wake up from the sleep when HLApp writes (or reads) a message
+    EnableIntercoreIrq(TimerUtil_NotifyWakeup);
+
+    return true;
+}
+
+// Wait and receive request from HLApp
+//  (the returned message is valid until the next call; an invalid request
+//   is answered with the error status here)
+const DI_DriverMsg*
+InterCoreComm_WaitAndRecvRequest()
+{
+    while (true) {
+        RequestSlot*	slot;
+        const InterCoreMsgHdr*	hdr;
+        uint32_t	msgSize;
+        uint16_t	status;
+
+        // release the previous request
+        if (sHasCurrent) {
+            PerfStats_AddHist(&PerfStats_Get()->requestUs,
+                TimerUtil_GetMicroseconds() - sCurrentStartUs);
+            sRequestHead = (sRequestHead + 1) % REQUEST_QUEUE_NUM;
+            sRequestCount--;
+            sHasCurrent = false;
+        }
+
+        // wait request message arrives while sleep
+        InterCoreComm_FlushSamples();
+        InterCoreComm_FetchRequests();
+        if (0 == sRequestCount) {
+            TimerUtil_SleepFor(InterCoreComm_GetFlushDelayMs());
+            continue;
+        }
+        slot = &sRequests[sRequestHead];
+        sHasCurrent = true;
+        sCurrentStartUs = TimerUtil_GetMicroseconds();
+        PerfStats_Get()->requests++;
+
+        // check the received message's integrity
+        if (slot->dataSize < INTERCORE_PREFIX_LEN + sizeof(InterCoreMsgHdr)) {
+            continue;  // too short message, can't reply
+        }
+        hdr = (const InterCoreMsgHdr*)(slot->buf + INTERCORE_PREFIX_LEN);
+        memcpy(sPeerPrefix, slot->buf, INTERCORE_PREFIX_LEN);
+        sHasPeer = true;
+        sCurrentHdr = *hdr;
+        msgSize = slot->dataSize - INTERCORE_PREFIX_LEN - sizeof(InterCoreMsgHdr);
+        if (hdr->version != INTERCORE_PROTOCOL_VERSION || hdr->payloadLen > msgSize) {
+            InterCoreComm_SendStatus(INTERCORE_STATUS_BAD_REQUEST);
+            continue;
+        }
+        status = InterCoreComm_CheckRequest((const DI_DriverMsg*)(hdr + 1), hdr->payloadLen);
+        if (status != INTERCORE_STATUS_OK) {
+            InterCoreComm_SendStatus(status);
+            continue;
+        }
+
+        return (const DI_DriverMsg*)(hdr + 1);
+    }
+}
+
+// Time until the samples should be sent (msec)
+//  (TIMERUTIL_SLEEP_FOREVER if no sample is waiting)
+uint32_t
+InterCoreComm_GetFlushDelayMs()
+{
+    uint32_t	tail  = sSampleTail;
+    uint32_t	count = sSampleHead - tail;
+    uint32_t	waitedMs;
+
+    if (! sHasPeer || (0 == count && sSampleDropped == sSampleDroppedSent)) {
+        return TIMERUTIL_SLEEP_FOREVER;
+    }
+    if (sIsFlushBlocked) {
+        return SAMPLE_FLUSH_MS;  // retry later (or when HLApp reads)
+    }
+    if (count >= INTERCORE_SAMPLE_BATCH_MAX || 0 == count) {
+        return 0;
+    }
+    waitedMs = (TimerUtil_GetMicroseconds()
+        - sSamples[tail % SAMPLE_RING_NUM].timestamp) / 1000;
+
+    return (waitedMs < SAMPLE_FLUSH_MS) ? SAMPLE_FLUSH_MS - waitedMs : 0;
+}
+
+// Build the reply to the current request in place
+//  (reserve the reply of up to maxLen bytes payload and returns the payload
+//   area, NULL if no space; then commit it with the actual length)
+uint8_t*
+InterCoreComm_ReserveReply(uint16_t maxLen)
+{
+    uint32_t	size = INTERCORE_PREFIX_LEN + sizeof(InterCoreMsgHdr) + maxLen;
+
+    sReplyBuf = NULL;
+    sIsReplyInRing = false;
+    if (! (sCurrentHdr.flags & INTERCORE_FLAG_NO_REPLY)) {
+        sReplyBuf = ReserveData(sInboundBuf, sOutboundBuf, sRingBufSize, size);
+        sIsReplyInRing = (NULL != sReplyBuf);
+    }
+    if (! sIsReplyInRing) {
+        // the reply would wrap around the end of the ring (or won't be sent)
+        if (size > sizeof(sSendBuf)) {
+            return NULL;
+        }
+        sReplyBuf = sSendBuf;
+    }
+    // the GUID prefix of the request is sent back as is
+    memcpy(sReplyBuf, sRequests[sRequestHead].buf, INTERCORE_PREFIX_LEN);
+
+    return sReplyBuf + INTERCORE_PREFIX_LEN + sizeof(InterCoreMsgHdr);
+}
+
+bool
+InterCoreComm_CommitReply(uint16_t status, uint16_t len)
+{
+    InterCoreMsgHdr*	hdr;
+    uint32_t	size = INTERCORE_PREFIX_LEN + sizeof(InterCoreMsgHdr) + len;
+    bool	ret = true;
+
+    if (NULL == sReplyBuf) {
+        return false;
+    }
+    hdr = (InterCoreMsgHdr*)(sReplyBuf + INTERCORE_PREFIX_LEN);
+    hdr->version    = INTERCORE_PROTOCOL_VERSION;
+    hdr->flags      = 0;
+    hdr->status     = status;
+    hdr->seq        = sCurrentHdr.seq;
+    hdr->payloadLen = len;
+    if (sCurrentHdr.flags & INTERCORE_FLAG_NO_REPLY) {
+        ;  // discard
+    } else if (sIsReplyInRing) {
+        CommitData(sOutboundBuf, sRingBufSize, size);
+    } else {
+        ret = (0 == EnqueueData(sInboundBuf, sOutboundBuf, sRingBufSize,
+            sSendBuf, size));
     }
+    sReplyBuf = NULL;
 
-    return sDriverMsgBuf;
+    return ret;
 }
 
 // Send response data to HLApp
 bool
 InterCoreComm_SendReadData(const uint8_t* data, uint16_t len)
 {
-    if (len > sizeof(sRecvBuf) - 20) {
+    if (len > sizeof(sSendBuf) - INTERCORE_PREFIX_LEN - sizeof(InterCoreMsgHdr)) {
         return false;
     }
-    return InterCoreComm_SendData(data, len);
+    return InterCoreComm_SendReply(INTERCORE_STATUS_OK, data, len);
 }
 
 bool
 InterCoreComm_SendIntValue(int val)
 {
-    return InterCoreComm_SendData((uint8_t*)&val, sizeof(val));
+    uint8_t*	payload = InterCoreComm_ReserveReply(sizeof(val));
+
+    if (NULL == payload) {
+        return false;
+    }
+    memcpy(payload, &val, sizeof(val));
+
+    return InterCoreComm_CommitReply(INTERCORE_STATUS_OK, sizeof(val));
+}
+
+// Send back the error status to HLApp (without payload)
+bool
+InterCoreComm_SendStatus(uint16_t status)
+{
+    if (INTERCORE_STATUS_OK != status) {
+        PerfStats_Get()->rejected++;
+    }
+
+    return InterCoreComm_SendReply(status, NULL, 0);
+}
+
+// Append a sample to be sent to HLApp
+//  (can be called from an interrupt handler, but only from one context)
+bool
+InterCoreComm_AppendSample(uint16_t kind, uint16_t source, uint32_t value)
+{
+    uint32_t	head = sSampleHead;
+    InterCoreSample*	rec;
+
+    if (head - sSampleTail >= SAMPLE_RING_NUM) {
+        sSampleDropped++;
+        PerfStats_Get()->samplesDropped++;
+        return false;
+    }
+    rec = &sSamples[head % SAMPLE_RING_NUM];
+    rec->timestamp = TimerUtil_GetMicroseconds();
+    rec->source    = source;
+    rec->kind      = kind;
+    rec->value     = value;
+    __sync_synchronize();  // publish the record before the head
+    sSampleHead = head + 1;
+    if (head - sSampleTail + 1 >= INTERCORE_SAMPLE_BATCH_MAX) {
+        TimerUtil_NotifyWakeup();  // a batch is full, send it now
+    }
+
+    return true;
 }
@@ -35,6 +35,9 @@
 #ifndef _DI_DRIVER_MSG_H_
 #include "DIDriveMsg.h"
 #endif
+#ifndef _INTER_CORE_MSG_H_
+#include "InterCoreMsg.h"
+#endif
 
 // Initialization
 extern bool	InterCoreComm_Initialize();
@@ -46,5 +49,14 @@ extern const DI_DriverMsg*	InterCoreComm_WaitAndRecvRequest();
 // Send response data to HLApp
 extern bool	InterCoreComm_SendReadData(const uint8_t* data, uint16_t len);
 extern bool	InterCoreComm_SendIntValue(int val);
+extern bool	InterCoreComm_SendStatus(uint16_t status);
+
+// Build the reply in place (reserve, write the payload, and commit)
+extern uint8_t*	InterCoreComm_ReserveReply(uint16_t maxLen);
+extern bool	InterCoreComm_CommitReply(uint16_t status, uint16_t len);
+
+// Append a sample to the stream to HLApp (INTERCORE_SAMPLE_xx)
+extern bool	InterCoreComm_AppendSample(uint16_t kind, uint16_t source, uint32_t value);
+extern uint32_t	InterCoreComm_GetFlushDelayMs();  // until the samples should be sent
 
 #endif  // _INTER_CORE_COMM_H_
@@ -116,10 +116,11 @@ PulseCounter_GetPinLevel(PulseCounter* me)
 //
 // Handle polling based pulse counting task
 //
-void
+bool
 PulseCounter_Counter(PulseCounter* me)
 {
     bool newState;
+    bool isSettled = false;
 
     // check DIn pin's input level and do pulse counting task as state machine
     Mt3620_Gpio_Read(me->pinId, &newState);
@@ -146,6 +147,7 @@ PulseCounter_Counter(PulseCounter* me)
                 }
                 me->pulseElapsedTime = 0;
                 me->isSetPulse = true;
+                isSettled = true;
             }
         } else if (me->isRising) {
             me->pulseOnTime++;
@@ -155,4 +157,6 @@ PulseCounter_Counter(PulseCounter* me)
             }
         }
     }
+
+    return isSettled;
 }
@@ -64,6 +64,7 @@ extern bool PulseCounter_GetLevel(PulseCounter* me);
 extern bool PulseCounter_GetPinLevel(PulseCounter* me);
 
 // Handle polling based pulse counting task
-extern void PulseCounter_Counter(PulseCounter* me);
+//  (returns whether an edge has been settled by this call)
+extern bool PulseCounter_Counter(PulseCounter* me);
 
 #endif  // _PULSE_COUNTER_H_
@@ -35,10 +35,19 @@
 // Initialization
 extern bool	TimerUtil_Initialize();
 
+// sleep time to wait only for the interrupts
+#define TIMERUTIL_SLEEP_FOREVER	UINT32_MAX
+
 // Sleep
 extern void	TimerUtil_SleepUntilIntr();
+extern void	TimerUtil_SleepFor(uint32_t maxMs);  // until interrupted or maxMs passed
+extern void	TimerUtil_NotifyWakeup();  // (from an interrupt handler) end the sleep
+extern void	TimerUtil_WaitUs(uint32_t us);  // busy wait
 
 // tick count (count/msec)
 extern uint32_t	TimerUtil_GetTickCount();
 
+// elapsed time (count/usec, wraps around; compare by the difference)
+extern uint32_t	TimerUtil_GetMicroseconds();
+
 #endif  // _TIMER_UTIL_H_
@@ -36,6 +36,7 @@
 #include "mt3620-timer.h"
 
 #include "InterCoreComm.h"
+#include "PerfStats.h"
 #include "TimerUtil.h"
 #include "PulseCounter.h"
 
@@ -52,6 +53,10 @@ const int DIPIN_2 = 2;
 const int DIPIN_3 = 3;
 static const int periodMs = 1;  // 1[ms] (for polling DIn pin's input level) 
 static PulseCounter sPulseCounter[NUM_DI];
+static volatile uint32_t sStreamPinMask = 0;  // pins which stream their edges
+static uint32_t sPrevIrqUs;                    // time of the previous interrupt
+static bool sHasPrevIrq = false;
+static volatile bool sIsSampling = false;      // the polling timer is running
 
 
 extern uint32_t StackTop; // &StackTop == end of TCM
@@ -63,12 +68,57 @@ static _Noreturn void RTCoreMain(void);
 static void
 Handle1msIrq(void)
 {
+    InterCoreStats* stats = PerfStats_Get();
+    uint32_t startUs = TimerUtil_GetMicroseconds();
+    bool isStarted = false;
+
+    // keep polling only while some pulse counter is started
+    for (int i = 0; i < NUM_DI; i++) {
+        isStarted = isStarted || sPulseCounter[i].isStart;
+    }
+    if (! isStarted) {
+        sIsSampling = false;
+        return;
+    }
+    // re-arm first, not to delay the next period by this handler
+    Gpt_LaunchTimerMs(TimerGpt1, periodMs, Handle1msIrq);
+
+    // count the periods passed without interrupt (the samples are missed)
+    if (sHasPrevIrq) {
+        uint32_t periods = (startUs - sPrevIrqUs) / (periodMs * 1000);
+
+        if (periods > 1) {
+            stats->timeouts += periods - 1;
+        }
+    }
+    sPrevIrqUs  = startUs;
+    sHasPrevIrq = true;
+
     for (int i = 0; i < NUM_DI; i++) {
         if (sPulseCounter[i].isStart) {
-            PulseCounter_Counter(&sPulseCounter[i]);
+            if (PulseCounter_Counter(&sPulseCounter[i])
+            &&  (sStreamPinMask & (UINT32_C(1) << i))) {
+                InterCoreComm_AppendSample(INTERCORE_SAMPLE_DI_EDGE,
+                    (uint16_t)sPulseCounter[i].pinId,
+                    sPulseCounter[i].currentState ? 1 : 0);
+            }
         }
     }
-    Gpt_LaunchTimerMs(TimerGpt1, periodMs, Handle1msIrq);
+
+    stats->events++;
+    PerfStats_AddHist(&stats->eventUs, TimerUtil_GetMicroseconds() - startUs);
+}
+
+// Start the polling timer if not running
+//  (call after starting a pulse counter)
+static void
+StartSampling(void)
+{
+    if (! sIsSampling) {
+        sIsSampling = true;
+        sHasPrevIrq = false;
+        Gpt_LaunchTimerMs(TimerGpt1, periodMs, Handle1msIrq);
+    }
 }
 
 static PulseCounter*
@@ -110,7 +160,9 @@ __attribute__((used)) = {
 
     [INT_TO_EXC(0)] = (uintptr_t)DefaultExceptionHandler,
     [INT_TO_EXC(1)] = (uintptr_t)Gpt_HandleIrq1,
-    [INT_TO_EXC(2)... INT_TO_EXC(INTERRUPT_COUNT - 1)] = (uintptr_t)DefaultExceptionHandler };
+    [INT_TO_EXC(2)... INT_TO_EXC(10)] = (uintptr_t)DefaultExceptionHandler,
+    [INT_TO_EXC(11)] = (uintptr_t)MT3620_HandleMailboxIrq11,
+    [INT_TO_EXC(12)... INT_TO_EXC(INTERRUPT_COUNT - 1)] = (uintptr_t)DefaultExceptionHandler };
 
 static _Noreturn void
 DefaultExceptionHandler(void)
@@ -130,6 +182,7 @@ RTCoreMain(void)
     if (! TimerUtil_Initialize()) {
         goto err;
     }
+    PerfStats_Initialize();
     if (! InterCoreComm_Initialize()) {
         goto err;
     }
@@ -140,7 +193,7 @@ RTCoreMain(void)
         uint32_t	tickCount     = prevTickCount;
 
         while (3000 > tickCount - prevTickCount) {
-            TimerUtil_SleepUntilIntr();
+            TimerUtil_SleepFor(3000 - (tickCount - prevTickCount));
             tickCount = TimerUtil_GetTickCount();
         }
     }
@@ -155,12 +208,12 @@ RTCoreMain(void)
     Mt3620_Gpio_ConfigurePinForInput(DIPIN_2);
     Mt3620_Gpio_ConfigurePinForInput(DIPIN_3);
 
-    // initialize pulse counters and start the polling timer
+    // initialize pulse counters
+    // (the polling timer runs while some of them are started)
     PulseCounter_Initialize(&sPulseCounter[0], DIPIN_0);
     PulseCounter_Initialize(&sPulseCounter[1], DIPIN_1);
     PulseCounter_Initialize(&sPulseCounter[2], DIPIN_2);
     PulseCounter_Initialize(&sPulseCounter[3], DIPIN_3);
-    Gpt_LaunchTimerMs(TimerGpt1, periodMs, Handle1msIrq);
 
     // main loop
     for (;;) {
@@ -169,7 +222,7 @@ RTCoreMain(void)
 
         if (msg != NULL) {
             PulseCounter*   targetP = NULL;
-            DI_ReturnMsg    retMsg;
+            DI_ReturnMsg*   retMsg;
             int val;
 
             switch (msg->header.requestCode) {
@@ -184,6 +237,7 @@ RTCoreMain(void)
                     msg->body.setConfig.minPulseWidth,
                     msg->body.setConfig.maxPulseCount
                 );
+                StartSampling();
                 if (InterCoreComm_SendIntValue(OK)) {
 //                    int i = 0;
                 }
@@ -195,6 +249,7 @@ RTCoreMain(void)
                     continue;
                 }
                 PulseCounter_Clear(targetP, msg->body.resetPulseCount.initVal);
+                StartSampling();
                 val = 1;
                 if (InterCoreComm_SendIntValue(val)) {
 //                    int i = 0;
@@ -224,12 +279,16 @@ RTCoreMain(void)
                 }
                 break;
             case DI_READ_PULSE_LEVEL:
+                retMsg = (DI_ReturnMsg*)InterCoreComm_ReserveReply(sizeof(DI_ReturnMsg));
+                if (retMsg == NULL) {
+                    continue;
+                }
                 for (int i = 0; i < NUM_DI; i++) {
-                    retMsg.message.levels[i] = PulseCounter_GetLevel(&sPulseCounter[i]);
+                    retMsg->message.levels[i] = PulseCounter_GetLevel(&sPulseCounter[i]);
                 }
-                retMsg.returnCode = OK;
-                retMsg.messageLen = sizeof(retMsg.message.levels);
-                if (InterCoreComm_SendReadData((uint8_t*)&retMsg, sizeof(DI_ReturnMsg))) {
+                retMsg->returnCode = OK;
+                retMsg->messageLen = sizeof(retMsg->message.levels);
+                if (InterCoreComm_CommitReply(INTERCORE_STATUS_OK, sizeof(DI_ReturnMsg))) {
 //                    int i = 0;
                 }
                 break;
@@ -245,18 +304,42 @@ RTCoreMain(void)
 //                    int i = 0;
                 }
                 break;
+            case DI_SET_SAMPLE_STREAM:
+                sStreamPinMask = msg->body.sampleStream.pinMask;
+                if (InterCoreComm_SendIntValue(OK)) {
+//                    int i = 0;
+                }
+                break;
+            case DI_READ_STATS:
+                {
+                    InterCoreStats* stats = (InterCoreStats*)InterCoreComm_ReserveReply(
+                        sizeof(InterCoreStats));
+
+                    if (stats == NULL) {
+                        break;
+                    }
+                    PerfStats_Read(stats, msg->body.stats.reset != 0);
+                    if (InterCoreComm_CommitReply(INTERCORE_STATUS_OK, sizeof(InterCoreStats))) {
+//                        int i = 0;
+                    }
+                }
+                break;
             case DI_READ_VERSION:
-                memset(retMsg.message.version, 0x00, sizeof(retMsg.message.version));
-                strncpy(retMsg.message.version, RTAPP_VERSION, strlen(RTAPP_VERSION) + 1);
-                retMsg.returnCode = OK;
-                retMsg.messageLen = strlen(RTAPP_VERSION);
-                if (InterCoreComm_SendReadData((uint8_t*)&retMsg, sizeof(DI_ReturnMsg))) {
+                retMsg = (DI_ReturnMsg*)InterCoreComm_ReserveReply(sizeof(DI_ReturnMsg));
+                if (retMsg == NULL) {
+                    continue;
+                }
+                memset(retMsg->message.version, 0x00, sizeof(retMsg->message.version));
+                strncpy(retMsg->message.version, RTAPP_VERSION, strlen(RTAPP_VERSION) + 1);
+                retMsg->returnCode = OK;
+                retMsg->messageLen = strlen(RTAPP_VERSION);
+                if (InterCoreComm_CommitReply(INTERCORE_STATUS_OK, sizeof(DI_ReturnMsg))) {
 //                    int i = 0;
                 }
                 break;
                 
             default:
-                InterCoreComm_SendIntValue(NG);
+                InterCoreComm_SendStatus(INTERCORE_STATUS_UNKNOWN);
                 break;
             }
         }
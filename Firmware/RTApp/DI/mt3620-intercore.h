@@ -6,6 +6,8 @@
 
 #include <stdint.h>
 
+#include "mt3620-baremetal.h"
+
 /// <summary>
 /// There are two buffers, inbound and outbound, which are used to track
 /// how much data has been written to, and read from, each shared buffer.
@@ -60,6 +62,37 @@ int GetIntercoreBuffers(BufferHeader **outbound, BufferHeader **inbound, uint32_
 int EnqueueData(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize, const void *src,
                 uint32_t dataSize);
 
+/// <summary>
+/// <para>Reserve a contiguous block in the shared buffer, so that the caller can write the data
+/// directly into it.  The block is not visible to the high-level application until
+/// <see cref="CommitData" /> is called.</para>
+/// </summary>
+/// <param name="inbound">The inbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="outbound">The outbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="bufSize">
+/// The total buffer size, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="maxDataSize">Maximum length of data to write in bytes.</param>
+/// <returns>Start of the block's data area, or NULL if there is not enough space or the block
+/// would wrap around the end of the buffer (use <see cref="EnqueueData" /> then).</returns>
+uint8_t *ReserveData(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize,
+                     uint32_t maxDataSize);
+
+/// <summary>
+/// Make the block reserved by <see cref="ReserveData" /> visible to the high-level
+/// application.
+/// </summary>
+/// <param name="outbound">The outbound buffer, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="bufSize">
+/// The total buffer size, as obtained from <see cref="GetIntercoreBuffers" />.
+/// </param>
+/// <param name="dataSize">Actual length of the written data in bytes (up to maxDataSize of
+/// <see cref="ReserveData" />).</param>
+void CommitData(BufferHeader *outbound, uint32_t bufSize, uint32_t dataSize);
+
 /// <summary>
 /// Remove data from the shared buffer, which has been written by the high-level application.
 /// </summary>
@@ -76,4 +109,23 @@ int EnqueueData(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize,
 int DequeueData(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize, void *dest,
                 uint32_t *dataSize);
 
+/// <summary>The mailbox interrupt (and hence callback) runs at this priority level.</summary>
+static const uint32_t MAILBOX_PRIORITY = 2;
+
+/// <summary>
+/// <para>Enable the interrupt which the high-level application raises when it has written
+/// a message to the shared buffer, or has read a message from it. The callback runs in
+/// interrupt context.</para>
+/// <para>The application should install <see cref="MT3620_HandleMailboxIrq11" /> as the
+/// INT11 handler in the exception table before calling this function.</para>
+/// </summary>
+/// <param name="callback">Function to invoke in interrupt context.</param>
+void EnableIntercoreIrq(Callback callback);
+
+/// <summary>
+/// To use the mailbox interrupt, install this function as the INT11 handler in the exception
+/// table. Applications should not call this function directly.
+/// </summary>
+void MT3620_HandleMailboxIrq11(void);
+
 #endif // #ifndef MT3620_INTERCORE_H
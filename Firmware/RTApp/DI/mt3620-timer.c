@@ -19,6 +19,13 @@ static const GptInfo gptRegOffsets[TIMER_GPT_COUNT] = {
     [TimerGpt0] = {.ctrlRegOffset = 0x10, .icntRegOffset = 0x14},
     [TimerGpt1] = {.ctrlRegOffset = 0x20, .icntRegOffset = 0x24}};
 
+// GPT3 is a free-running up counter without interrupt.
+static const size_t GPT3_CTRL = 0x50;
+static const size_t GPT3_INIT = 0x54;
+static const size_t GPT3_CNT = 0x58;
+// GPT3 counts the 26MHz oscillator clock divided by (GPT3_CTRL[6:1] + 1).
+static const uint32_t GPT3_OSC_CNT_1US = 26 - 1;
+
 void Gpt_Init(void)
 {
     // Enable INT1 in the NVIC. This allows the processor to receive an interrupt
@@ -72,3 +79,18 @@ void Gpt_LaunchTimerMs(TimerGpt gpt, uint32_t periodMs, Callback callback)
     // GPTx_CTRL -> auto clear; 1kHz, one shot, enable timer.
     WriteReg32(GPT_BASE, gptRegOffsets[gpt].ctrlRegOffset, 0x9);
 }
+
+void Gpt_StartFreeRunUs(void)
+{
+    // GPT3_CTRL[0] = 0 -> disable, then restart the count from zero.
+    WriteReg32(GPT_BASE, GPT3_CTRL, 0x0);
+    WriteReg32(GPT_BASE, GPT3_INIT, 0x0);
+
+    // GPT3_CTRL -> 1MHz, enable timer.
+    WriteReg32(GPT_BASE, GPT3_CTRL, (GPT3_OSC_CNT_1US << 1) | 0x1);
+}
+
+uint32_t Gpt_ReadFreeRunUs(void)
+{
+    return ReadReg32(GPT_BASE, GPT3_CNT);
+}
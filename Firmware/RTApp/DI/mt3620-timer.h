@@ -52,4 +52,18 @@ void Gpt_HandleIrq1(void);
 /// <param name="callback">Function to invoke in interrupt context when the timer expires.</param>
 void Gpt_LaunchTimerMs(TimerGpt gpt, uint32_t periodMs, Callback callback);
 
+/// <summary>
+/// <para>Start GPT3 as a free-running counter which counts up every microsecond.
+/// It doesn't raise an interrupt and wraps around after about 71 minutes.</para>
+/// <para>Call this once, from the main application thread.</para>
+/// </summary>
+void Gpt_StartFreeRunUs(void);
+
+/// <summary>
+/// Read the free-running counter started by <see cref="Gpt_StartFreeRunUs" />.
+/// This can be called from any context.
+/// </summary>
+/// <returns>Elapsed time in microseconds (modulo 2^32).</returns>
+uint32_t Gpt_ReadFreeRunUs(void);
+
 #endif /* MT3620_TIMER_H */
@@ -0,0 +1,185 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "ModbusPoller.h"
+
+#include <stddef.h>  // for NULL
+
+#include "InterCoreComm.h"
+#include "TimerUtil.h"
+
+#define FC_READ_HOLDING_REGISTER	0x03
+#define FC_READ_INPUT_REGISTERS 	0x04
+#define REQ_LEN 	8  // slave ID + function + address + count + CRC
+#define RSP_LEN(regCount)	(5 + (regCount) * 2)  // slave ID + function + byte count + registers + CRC
+
+static UART_PollEntry	sEntries[UART_POLL_PLAN_MAX];
+static uint32_t	sNextMs[UART_POLL_PLAN_MAX];  // tick count of the next polling
+static uint32_t	sEntryNum = 0;
+
+static uint16_t
+ModbusPoller_CalcCRC(const uint8_t* data, int len)
+{
+    uint16_t	crc = 0xFFFF;
+
+    for (int i = 0; i < len; i++) {
+        crc = (uint16_t)(crc ^ data[i]);
+        for (int j = 0; j < 8; j++) {
+            if (crc & 1) {
+                crc = (uint16_t)((crc >> 1) ^ 0xA001);
+            } else {
+                crc = (uint16_t)(crc >> 1);
+            }
+        }
+    }
+
+    return crc;
+}
+
+// Check the response (slave ID, function, byte count and CRC)
+static bool
+ModbusPoller_CheckResponse(const UART_PollEntry* entry, const uint8_t* rsp)
+{
+    uint16_t	len = RSP_LEN(entry->regCount);
+    uint16_t	crc;
+
+    if (rsp[0] != entry->devId || rsp[1] != entry->funcCode ||
+        rsp[2] != entry->regCount * 2) {
+        return false;
+    }
+    crc = ModbusPoller_CalcCRC(rsp, len - 2);
+
+    return (rsp[len - 2] == (uint8_t)crc && rsp[len - 1] == (uint8_t)(crc >> 8));
+}
+
+// Set the poll plan (no entry stops polling)
+bool
+ModbusPoller_SetPlan(const UART_MsgPollPlan* plan)
+{
+    uint32_t	now = TimerUtil_GetTickCount();
+
+    if (plan->entryNum > UART_POLL_PLAN_MAX) {
+        return false;
+    }
+    for (uint32_t i = 0; i < plan->entryNum; i++) {
+        const UART_PollEntry*	entry = &plan->entries[i];
+
+        if (0 == entry->periodMs || 0 == entry->regCount
+            || entry->regCount > UART_POLL_REGS_MAX
+            || (entry->funcCode != FC_READ_HOLDING_REGISTER
+                && entry->funcCode != FC_READ_INPUT_REGISTERS)) {
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < plan->entryNum; i++) {
+        sEntries[i] = plan->entries[i];
+        sNextMs[i]  = now + plan->entries[i].phaseMs;
+    }
+    sEntryNum = plan->entryNum;
+
+    return true;
+}
+
+// Poll the device of the entry which is due, if any
+bool
+ModbusPoller_PollDue(ModbusPoller_Transact transact)
+{
+    uint32_t	now = TimerUtil_GetTickCount();
+    int	due = -1;
+    const UART_PollEntry*	entry;
+    uint8_t	req[REQ_LEN];
+    uint8_t	rsp[RSP_LEN(UART_POLL_REGS_MAX)];
+    uint16_t	crc;
+
+    // the most overdue entry first
+    for (uint32_t i = 0; i < sEntryNum; i++) {
+        if (0 <= (int32_t)(now - sNextMs[i])
+            && (due < 0 || 0 < (int32_t)(sNextMs[due] - sNextMs[i]))) {
+            due = (int)i;
+        }
+    }
+    if (due < 0) {
+        return false;
+    }
+    entry = &sEntries[due];
+
+    // read the registers
+    req[0] = entry->devId;
+    req[1] = entry->funcCode;
+    req[2] = (uint8_t)(entry->regAddr >> 8);
+    req[3] = (uint8_t)entry->regAddr;
+    req[4] = (uint8_t)(entry->regCount >> 8);
+    req[5] = (uint8_t)entry->regCount;
+    crc = ModbusPoller_CalcCRC(req, REQ_LEN - 2);
+    req[6] = (uint8_t)crc;
+    req[7] = (uint8_t)(crc >> 8);
+    if (! transact(entry, req, REQ_LEN, rsp, RSP_LEN(entry->regCount))) {
+        InterCoreComm_AppendSample(INTERCORE_SAMPLE_MODBUS_ERROR,
+            (uint16_t)(due << 8), INTERCORE_MODBUS_ERR_TIMEOUT);
+    } else if (! ModbusPoller_CheckResponse(entry, rsp)) {
+        InterCoreComm_AppendSample(INTERCORE_SAMPLE_MODBUS_ERROR,
+            (uint16_t)(due << 8), INTERCORE_MODBUS_ERR_RESPONSE);
+    } else {
+        for (uint16_t i = 0; i < entry->regCount; i++) {
+            uint32_t	value = (uint32_t)((rsp[3 + i * 2] << 8) | rsp[4 + i * 2]);
+
+            if (i + 1 == entry->regCount) {
+                value |= INTERCORE_SAMPLE_LAST_REG;
+            }
+            InterCoreComm_AppendSample(INTERCORE_SAMPLE_MODBUS_REG,
+                (uint16_t)((due << 8) | i), value);
+        }
+    }
+
+    // schedule the next polling (the periods already passed are skipped)
+    now = TimerUtil_GetTickCount();
+    do {
+        sNextMs[due] += entry->periodMs;
+    } while (0 <= (int32_t)(now - sNextMs[due]));
+
+    return true;
+}
+
+// Time until the next polling (msec, TIMERUTIL_SLEEP_FOREVER if no plan)
+uint32_t
+ModbusPoller_GetDelayMs(void)
+{
+    uint32_t	now = TimerUtil_GetTickCount();
+    uint32_t	delay = TIMERUTIL_SLEEP_FOREVER;
+
+    for (uint32_t i = 0; i < sEntryNum; i++) {
+        int32_t	remain = (int32_t)(sNextMs[i] - now);
+
+        if (remain <= 0) {
+            return 0;  // already due
+        }
+        if ((uint32_t)remain < delay) {
+            delay = (uint32_t)remain;
+        }
+    }
+
+    return delay;
+}
@@ -0,0 +1,55 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef _MODBUS_POLLER_H_
+#define _MODBUS_POLLER_H_
+
+#ifndef _STDBOOL_H
+#include <stdbool.h>
+#endif
+#ifndef _STDINT_H
+#include <stdint.h>
+#endif
+
+#ifndef _UART_DRIVER_MSG_H_
+#include "UartDriveMsg.h"
+#endif
+
+// Send the request to the device of the entry and receive its response
+// (returns false on timeout)
+typedef bool	(*ModbusPoller_Transact)(const UART_PollEntry* entry,
+    const uint8_t* req, uint16_t reqLen, uint8_t* rsp, uint16_t rspLen);
+
+// Set the poll plan (no entry stops polling)
+extern bool	ModbusPoller_SetPlan(const UART_MsgPollPlan* plan);
+
+// Poll the device of the entry which is due, if any
+// (returns whether an entry was polled)
+extern bool	ModbusPoller_PollDue(ModbusPoller_Transact transact);
+
+// Time until the next polling (msec, TIMERUTIL_SLEEP_FOREVER if no plan)
+extern uint32_t	ModbusPoller_GetDelayMs(void);
+
+#endif  // _MODBUS_POLLER_H_
@@ -0,0 +1,83 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2020 Atmark Techno, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "PerfStats.h"
+
+#include <string.h>
+
+#include "mt3620-baremetal.h"
+
+#include "TimerUtil.h"
+
+static InterCoreStats	sStats;
+static uint32_t	sResetMs = 0;  // tick count of the last reset
+
+// Initialization
+void
+PerfStats_Initialize()
+{
+    memset(&sStats, 0, sizeof(sStats));
+    sResetMs = TimerUtil_GetTickCount();
+}
+
+// Counters
+InterCoreStats*
+PerfStats_Get()
+{
+    return &sStats;
+}
+
+// Add a duration to the histogram
+//  (bin n: [2^n, 2^(n+1)) [usec])
+void
+PerfStats_AddHist(InterCoreHist* hist, uint32_t us)
+{
+    int	bin = 31 - __builtin_clz(us | 1);
+
+    if (bin >= INTERCORE_HIST_BINS) {
+        bin = INTERCORE_HIST_BINS - 1;
+    }
+    hist->bins[bin]++;
+    hist->count++;
+    if (hist->maxUs < us) {
+        hist->maxUs = us;
+    }
+}
+
+// Read the statistics (and reset them)
+void
+PerfStats_Read(InterCoreStats* outStats, bool reset)
+{
+    uint32_t	now = TimerUtil_GetTickCount();
+    uint32_t	prevBasePri = BlockIrqs();  // (updated by interrupt handler)
+
+    *outStats = sStats;
+    outStats->periodMs = now - sResetMs;
+    if (reset) {
+        memset(&sStats, 0, sizeof(sStats));
+        sResetMs = now;
+    }
+    RestoreIrqs(prevBasePri);
+}
@@ -24,38 +24,116 @@
 
 #include "TimerUtil.h"
 
+#include "mt3620-baremetal.h"
 #include "mt3620-timer.h"
 
-static uint32_t	sTickCount = 0;
+// longest sleep at a time, to keep track of the wrap-around of the counter
+// (it wraps around after about 71[min])
+#define SLEEP_MAX_MS	60000
+
+static uint32_t	sUsLow  = 0;  // last read of the free-running counter
+static uint32_t	sUsHigh = 0;  // wrap-around count of the free-running counter
+static volatile bool	sWakeup = false;  // the sleep should end
+
+// elapsed time (usec) extended to 64 bits
+static uint64_t
+TimerUtil_GetMicroseconds64()
+{
+    uint32_t	prevBasePri = BlockIrqs();
+    uint32_t	low = Gpt_ReadFreeRunUs();
+    uint64_t	us;
+
+    if (low < sUsLow) {
+        sUsHigh++;  // wrapped around
+    }
+    sUsLow = low;
+    us = ((uint64_t)sUsHigh << 32) | low;
+    RestoreIrqs(prevBasePri);
+
+    return us;
+}
 
 static void
 TimerCallback()
 {
-    sTickCount += 10;  // 10[ms/intr]
-    Gpt_LaunchTimerMs(TimerGpt0, 10, TimerCallback);
+    // wake up the sleep, and keep track of the wrap-around of the counter
+    (void)TimerUtil_GetMicroseconds64();
+    sWakeup = true;
 }
 
 // Initialization
 bool
 TimerUtil_Initialize()
 {
-    // interrupt setting at 10 [ms] cycle
+    // free-running counter at 1 [us] resolution
+    // (GPT0 is armed only while sleeping, for the next deadline)
     Gpt_Init();
-    Gpt_LaunchTimerMs(TimerGpt0, 10, TimerCallback);
+    Gpt_StartFreeRunUs();
 
     return true;
 }
 
-// Sleep
+// Sleep until an interrupt handler requests to wake up
 void
 TimerUtil_SleepUntilIntr()
 {
-    __asm__("wfi");
+    TimerUtil_SleepFor(TIMERUTIL_SLEEP_FOREVER);
+}
+
+// Sleep until an interrupt handler requests to wake up or maxMs passed
+void
+TimerUtil_SleepFor(uint32_t maxMs)
+{
+    if (0 == maxMs) {
+        return;
+    }
+    if (maxMs > SLEEP_MAX_MS) {
+        maxMs = SLEEP_MAX_MS;
+    }
+    (void)TimerUtil_GetMicroseconds64();  // keep track of the wrap-around
+    Gpt_LaunchTimerMs(TimerGpt0, maxMs, TimerCallback);
+
+    // the wake up request between the check and wfi is not lost, because
+    // a pending interrupt ends wfi even while the interrupts are masked
+    // (the other interrupts are handled and the sleep continues)
+    __asm__ volatile("cpsid i" ::: "memory");
+    while (! sWakeup) {
+        __asm__ volatile("wfi");
+        __asm__ volatile("cpsie i" ::: "memory");  // handle the interrupt
+        __asm__ volatile("cpsid i" ::: "memory");
+    }
+    sWakeup = false;
+    __asm__ volatile("cpsie i" ::: "memory");
+}
+
+// Request to end the sleep (from an interrupt handler)
+void
+TimerUtil_NotifyWakeup()
+{
+    sWakeup = true;
+}
+
+// Busy wait
+void
+TimerUtil_WaitUs(uint32_t us)
+{
+    uint32_t	start = Gpt_ReadFreeRunUs();
+
+    while (Gpt_ReadFreeRunUs() - start < us) {
+        // just wait
+    }
 }
 
 // tick count (count/msec)
 uint32_t
 TimerUtil_GetTickCount()
 {
-    return sTickCount;
+    return (uint32_t)(TimerUtil_GetMicroseconds64() / 1000);
+}
+
+// elapsed time (count/usec, wraps around)
+uint32_t
+TimerUtil_GetMicroseconds()
+{
+    return Gpt_ReadFreeRunUs();
 }
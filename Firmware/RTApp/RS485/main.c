@@ -36,11 +36,13 @@
 #include "mt3620-timer.h"
 
 #include "InterCoreComm.h"
+#include "ModbusPoller.h"
+#include "PerfStats.h"
 #include "TimerUtil.h"
 #include "UartDriveMsg.h"
 
 
-const int TIMEOUT = 400; // 400[ms]
+const uint32_t TIMEOUT = 400 * 1000; // 400[ms] until the response begins
 
 #define OK  1
 #define NG  -1
@@ -66,7 +68,7 @@ typedef unsigned int u32;
 #define UART_LCR_STB_SHIFT		(2)
 #define UART_LCR_WLS_SHIFT		(0)
 
-#define RX_BUFFER_SIZE 8
+#define RX_BUFFER_SIZE 256
 
 extern uint32_t StackTop; // &StackTop == end of TCM
 
@@ -75,6 +77,16 @@ static _Noreturn void DefaultExceptionHandler(void);
 // ISU3 UART Base Address
 static const uintptr_t UART_BASE = 0x380a0500;
 
+// current serial line settings
+static bool     sIsUartInitialized = false;
+static uint32_t sBaudRate;
+static uint8_t  sParity;
+static uint8_t  sStop;
+
+// Modbus RTU frame timing
+static uint32_t sFrameGapUs = 1750;  // silent interval between frames (3.5 characters)
+static uint32_t sLastBusUs  = 0;     // time of the last bus activity
+
 
 static
 void Uart_Init(void)
@@ -179,7 +191,8 @@ static bool
 Uart_ReadPoll(uint8_t *buffer, int len) {
     int val;
     int counter = 0;
-    int recvTime = TimerUtil_GetTickCount();
+    uint32_t timeout = TIMEOUT;
+    uint32_t recvTime = TimerUtil_GetMicroseconds();
 
     // read 1 byte at a time while waiting for data register fill
     //
@@ -187,18 +200,22 @@ Uart_ReadPoll(uint8_t *buffer, int len) {
     memset(buffer, 0, len);
     for (int i = 0; i < len; i++) {
         while (0 == (ReadReg32(UART_BASE, 0x14) & 0x01)) {
-            if (TimerUtil_GetTickCount() - recvTime > TIMEOUT) {
-                return false;  // timed out
+            if (TimerUtil_GetMicroseconds() - recvTime > timeout) {
+                sLastBusUs = TimerUtil_GetMicroseconds();
+                return false;  // timed out (or the frame ended)
             }
         }
         val = (uint8_t)ReadReg32(UART_BASE, 0x00);
+        PerfStats_Get()->rxBytes++;
         if (val != 0) {
             buffer[counter++] = val;
         } else if (val == 0 && counter > 0) {
             buffer[counter++] = val;
         }
-        recvTime = TimerUtil_GetTickCount();
+        recvTime = TimerUtil_GetMicroseconds();
+        timeout  = sFrameGapUs;  // the frame ends with the silent interval
     }
+    sLastBusUs = recvTime;
 
     return true;
 }
@@ -213,6 +230,81 @@ Uart_DataSkip() {
     }
 }
 
+static void
+Uart_SetParams(uint32_t baudRate, uint8_t parity, uint8_t stop)
+{
+    Uart_Init();
+    mtk_hdl_uart_set_params(baudRate, parity, stop);
+
+    // 3.5 characters of 1 start bit, 8 data bits, parity bit and stop bits
+    // (fixed to 1750[us] above 19200[bps] by the specification)
+    if (baudRate > 19200) {
+        sFrameGapUs = 1750;
+    } else {
+        uint32_t bits = 1 + 8 + (parity ? 1 : 0) + stop;
+
+        sFrameGapUs = (uint32_t)((uint64_t)bits * 3500000 / baudRate);
+    }
+    sBaudRate = baudRate;
+    sParity   = parity;
+    sStop     = stop;
+    sIsUartInitialized = true;
+}
+
+// Send the request to the opposing device and receive the response
+static bool
+Uart_Transact(const uint8_t* writeData, uint16_t writeLen,
+    uint8_t* readBuf, uint16_t readLen)
+{
+    InterCoreStats* stats = PerfStats_Get();
+    uint32_t elapsed;
+    uint32_t startUs;
+    bool isRead;
+
+    // keep the silent interval after the previous frame
+    // (in case of 9600bps, about 4[ms])
+    elapsed = TimerUtil_GetMicroseconds() - sLastBusUs;
+    if (elapsed < sFrameGapUs) {
+        TimerUtil_WaitUs(sFrameGapUs - elapsed);
+    }
+    Uart_DataSkip();  // read out unknown received data
+    startUs = TimerUtil_GetMicroseconds();
+
+    // send request to the opposing device via RS-485
+    Mt3620_Gpio_Write(21, true);  // DE (enable)
+    Mt3620_Gpio_Write(23, true);  // RE_N (disable)
+    Uart_WritePoll((const char*)writeData, writeLen);
+    sLastBusUs = TimerUtil_GetMicroseconds();
+
+    // receive response from the opposing device
+    Mt3620_Gpio_Write(21, false);
+    Mt3620_Gpio_Write(23, false);
+
+    isRead = Uart_ReadPoll(readBuf, readLen);
+
+    stats->events++;
+    stats->txBytes += writeLen;
+    if (! isRead) {
+        stats->timeouts++;
+    }
+    PerfStats_AddHist(&stats->eventUs, sLastBusUs - startUs);
+
+    return isRead;
+}
+
+// Transaction of the poll plan (switch the serial line settings if differ)
+static bool
+Poll_Transact(const UART_PollEntry* entry, const uint8_t* req, uint16_t reqLen,
+    uint8_t* rsp, uint16_t rspLen)
+{
+    if (! sIsUartInitialized || entry->baudRate != sBaudRate
+        || entry->parity != sParity || entry->stop != sStop) {
+        Uart_SetParams(entry->baudRate, entry->parity, entry->stop);
+    }
+
+    return Uart_Transact(req, reqLen, rsp, rspLen);
+}
+
 static _Noreturn void RTCoreMain(void);
 
 // ARM DDI0403E.d SB1.5.2-3
@@ -241,7 +333,9 @@ __attribute__((used)) = {
 
     [INT_TO_EXC(0)] = (uintptr_t)DefaultExceptionHandler,
     [INT_TO_EXC(1)] = (uintptr_t)Gpt_HandleIrq1,
-    [INT_TO_EXC(2)... INT_TO_EXC(INTERRUPT_COUNT - 1)] = (uintptr_t)DefaultExceptionHandler };
+    [INT_TO_EXC(2)... INT_TO_EXC(10)] = (uintptr_t)DefaultExceptionHandler,
+    [INT_TO_EXC(11)] = (uintptr_t)MT3620_HandleMailboxIrq11,
+    [INT_TO_EXC(12)... INT_TO_EXC(INTERRUPT_COUNT - 1)] = (uintptr_t)DefaultExceptionHandler };
 
 static _Noreturn void
 DefaultExceptionHandler(void)
@@ -255,7 +349,6 @@ static _Noreturn void
 RTCoreMain(void)
 {
     uint8_t rxBuffer[RX_BUFFER_SIZE];
-    bool initializeUart = false;
 
     // SCB->VTOR = ExceptionVectorTable
     WriteReg32(SCB_BASE, 0x08, (uint32_t)ExceptionVectorTable);
@@ -264,6 +357,7 @@ RTCoreMain(void)
     if (! TimerUtil_Initialize()) {
         DefaultExceptionHandler();
     }
+    PerfStats_Initialize();
     if (! InterCoreComm_Initialize()) {
         DefaultExceptionHandler();
     }
@@ -275,7 +369,7 @@ RTCoreMain(void)
 
 
         while (3000 > tickCount - prevTickCount) {
-            TimerUtil_SleepUntilIntr();
+            TimerUtil_SleepFor(3000 - (tickCount - prevTickCount));
             tickCount = TimerUtil_GetTickCount();
         }
     }
@@ -295,66 +389,96 @@ RTCoreMain(void)
 
     // main loop
     for (;;) {
-        // wait and receive a request message from HLApp and process it
-        const UART_DriverMsg* msg = InterCoreComm_WaitAndRecvRequest();
+        // receive a request message from HLApp and process it,
+        // or poll the devices of the plan while no request arrives
+        const UART_DriverMsg* msg = InterCoreComm_RecvRequest();
 
         if (msg != NULL) {
-            UART_ReturnMsg    retMsg;
+            UART_ReturnMsg*   retMsg;
 
             switch (msg->header.requestCode) {
             case UART_REQ_WRITE_AND_READ:
-                if (initializeUart) {
-                    Uart_DataSkip();  // read out unknown received data
-
-                    // send request to the opposing device via RS-485
-                    Mt3620_Gpio_Write(21, true);  // DE (enable)
-                    Mt3620_Gpio_Write(23, true);  // RE_N (disable)
-                    Uart_WritePoll((const char*)msg->body.writeAndReadReq.writeData,
-                        msg->body.writeAndReadReq.writeLen);
-
-                    // receive response from the opposing device
-                    Mt3620_Gpio_Write(21, false);
-                    Mt3620_Gpio_Write(23, false);
-
-                    // send back the response to HLApp
-                    if (! Uart_ReadPoll(rxBuffer, msg->body.writeAndReadReq.readLen)) {
-                        memset(rxBuffer, 0, msg->body.writeAndReadReq.readLen);
-                        if (InterCoreComm_SendReadData(rxBuffer, msg->body.writeAndReadReq.readLen)) {
- //                           int i = -1;
-                        }
-                    } else if (InterCoreComm_SendReadData(rxBuffer, msg->body.writeAndReadReq.readLen)) {
+                if (sIsUartInitialized) {
+                    // receive the response directly into the reply to HLApp
+                    uint16_t readLen = msg->body.writeAndReadReq.readLen;
+                    if (readLen > RX_BUFFER_SIZE) {
+                        readLen = RX_BUFFER_SIZE;
+                    }
+                    uint8_t* rxData = InterCoreComm_ReserveReply(readLen);
+                    if (rxData == NULL) {
+                        rxData = rxBuffer;  // can't reply, only read out
+                    }
+                    if (! Uart_Transact(
+                            (const uint8_t*)msg->body.writeAndReadReq.writeData,
+                            msg->body.writeAndReadReq.writeLen, rxData, readLen)) {
+                        memset(rxData, 0, readLen);
+                    }
+                    if (InterCoreComm_CommitReply(INTERCORE_STATUS_OK, readLen)) {
  //                       int i = 1;
                     }
-                //
-                // NOTE: It should make time for equal of transmitting 3.5 characters 
-                //       according to Modbus RTU specification.
-                //       (in case of 9600bps, about 3[ms])
+                } else {
+                    InterCoreComm_SendStatus(INTERCORE_STATUS_NOT_READY);
                 }
                 break;
             case UART_REQ_SET_PARAMS:
                 // initialize UART with requested params, then send back the status code
                 // status code is
                 //   0: error, 1: OK
-                Uart_Init();
-                mtk_hdl_uart_set_params(msg->body.setParams.baudRate,
+                Uart_SetParams(msg->body.setParams.baudRate,
                     msg->body.setParams.parity, msg->body.setParams.stop);
-                initializeUart = true;
                 if (! InterCoreComm_SendIntValue(1)) {
 //                    int i = 0;
                 }
                 break;
+            case UART_REQ_SET_POLL_PLAN:
+                // replace the poll plan, then send back the status code
+                // status code is
+                //   0: error, 1: OK
+                if (ModbusPoller_SetPlan(&msg->body.pollPlan)) {
+                    InterCoreComm_DiscardSamples();  // of the previous plan
+                    InterCoreComm_SendIntValue(1);
+                } else {
+                    InterCoreComm_SendIntValue(0);
+                }
+                break;
+            case UART_REQ_STATS:
+                {
+                    InterCoreStats* stats = (InterCoreStats*)InterCoreComm_ReserveReply(
+                        sizeof(InterCoreStats));
+
+                    if (stats == NULL) {
+                        break;
+                    }
+                    PerfStats_Read(stats, msg->body.stats.reset != 0);
+                    if (InterCoreComm_CommitReply(INTERCORE_STATUS_OK, sizeof(InterCoreStats))) {
+                        ;
+                    }
+                }
+                break;
             case UART_REQ_VERSION:
-                memset(retMsg.message.version, 0x00, sizeof(retMsg.message.version));
-                strncpy(retMsg.message.version, RTAPP_VERSION, strlen(RTAPP_VERSION) + 1);
-                retMsg.returnCode = OK;
-                retMsg.messageLen = strlen(RTAPP_VERSION);
-                if (InterCoreComm_SendReadData((uint8_t*)&retMsg, sizeof(UART_ReturnMsg))) {
+                retMsg = (UART_ReturnMsg*)InterCoreComm_ReserveReply(sizeof(UART_ReturnMsg));
+                if (retMsg == NULL) {
+                    break;
+                }
+                memset(retMsg->message.version, 0x00, sizeof(retMsg->message.version));
+                strncpy(retMsg->message.version, RTAPP_VERSION, strlen(RTAPP_VERSION) + 1);
+                retMsg->returnCode = OK;
+                retMsg->messageLen = strlen(RTAPP_VERSION);
+                if (InterCoreComm_CommitReply(INTERCORE_STATUS_OK, sizeof(UART_ReturnMsg))) {
                     ;
                 }
                 break;
             default:
+                InterCoreComm_SendStatus(INTERCORE_STATUS_UNKNOWN);
                 break;
             }
+        } else if (! ModbusPoller_PollDue(Poll_Transact)) {
+            // sleep until the next polling or sending the samples
+            uint32_t	pollDelayMs  = ModbusPoller_GetDelayMs();
+            uint32_t	flushDelayMs = InterCoreComm_GetFlushDelayMs();
+
+            TimerUtil_SleepFor(
+                (pollDelayMs < flushDelayMs) ? pollDelayMs : flushDelayMs);
         }
     }
 }
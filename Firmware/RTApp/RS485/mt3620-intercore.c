@@ -23,12 +23,15 @@
  * THE SOFTWARE.
  */
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "mt3620-baremetal.h"
 #include "mt3620-intercore.h"
 
 static const uintptr_t MAILBOX_BASE = 0x21050000;
 
+static volatile Callback mailboxCallback = NULL;
+
 static void ReceiveMessage(uint32_t *command, uint32_t *data);
 static uint32_t GetBufferSize(uint32_t bufferBase);
 static BufferHeader *GetBufferHeader(uint32_t bufferBase);
@@ -180,6 +183,54 @@ int EnqueueData(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize,
     return 0;
 }
 
+uint8_t *ReserveData(BufferHeader *inbound, BufferHeader *outbound, uint32_t bufSize,
+                     uint32_t maxDataSize)
+{
+    uint32_t remoteReadPosition = inbound->readPosition;
+    uint32_t localWritePosition = outbound->writePosition;
+
+    if (remoteReadPosition >= bufSize) {
+        return NULL;
+    }
+
+    uint32_t availSpace;
+    if (remoteReadPosition <= localWritePosition) {
+        availSpace = remoteReadPosition - localWritePosition + bufSize;
+    } else {
+        availSpace = remoteReadPosition - localWritePosition;
+    }
+    if (availSpace < sizeof(uint32_t) + maxDataSize + RINGBUFFER_ALIGNMENT) {
+        return NULL;
+    }
+
+    // The block (including its size) must not wrap around the end of the buffer, so that the
+    // caller can write it directly.
+    if (bufSize - localWritePosition < sizeof(uint32_t) + maxDataSize) {
+        return NULL;
+    }
+
+    return DataAreaOffset8(outbound, localWritePosition + sizeof(uint32_t));
+}
+
+void CommitData(BufferHeader *outbound, uint32_t bufSize, uint32_t dataSize)
+{
+    uint32_t localWritePosition = outbound->writePosition;
+
+    // Write block size to first word in block.
+    *DataAreaOffset32(outbound, localWritePosition) = dataSize;
+
+    // Advance write position.
+    localWritePosition =
+        RoundUp(localWritePosition + sizeof(uint32_t) + dataSize, RINGBUFFER_ALIGNMENT);
+    if (localWritePosition >= bufSize) {
+        localWritePosition -= bufSize;
+    }
+    outbound->writePosition = localWritePosition;
+
+    // SW_TX_INT_PORT[0] = 1 -> indicate message received.
+    WriteReg32(MAILBOX_BASE, 0x14, 1U << 0);
+}
+
 int DequeueData(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize, void *dest,
                 uint32_t *dataSize)
 {
@@ -261,3 +312,26 @@ int DequeueData(BufferHeader *outbound, BufferHeader *inbound, uint32_t bufSize,
 
     return 0;
 }
+
+void EnableIntercoreIrq(Callback callback)
+{
+    mailboxCallback = callback;
+
+    // SW_RX_INT_EN[1:0] = 1 -> enable interrupt on message written/read by
+    // the high-level application.
+    WriteReg32(MAILBOX_BASE, 0x18, 0x3);
+
+    SetNvicPriority(11, MAILBOX_PRIORITY);
+    EnableNvicInterrupt(11);
+}
+
+void MT3620_HandleMailboxIrq11(void)
+{
+    // SW_RX_INT_STS -> read, clear interrupts.
+    uint32_t activeIrqs = ReadReg32(MAILBOX_BASE, 0x1C);
+    WriteReg32(MAILBOX_BASE, 0x1C, activeIrqs);
+
+    if (mailboxCallback != NULL) {
+        mailboxCallback();
+    }
+}